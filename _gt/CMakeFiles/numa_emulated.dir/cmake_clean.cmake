@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/numa_emulated.dir/tests/numa_emulated.cpp.o"
+  "CMakeFiles/numa_emulated.dir/tests/numa_emulated.cpp.o.d"
+  "numa_emulated"
+  "numa_emulated.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/numa_emulated.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
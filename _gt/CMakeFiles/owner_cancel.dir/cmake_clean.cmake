@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/owner_cancel.dir/tests/owner_cancel.cpp.o"
+  "CMakeFiles/owner_cancel.dir/tests/owner_cancel.cpp.o.d"
+  "owner_cancel"
+  "owner_cancel.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/owner_cancel.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/rt_stress.dir/tests/rt_stress.cpp.o"
+  "CMakeFiles/rt_stress.dir/tests/rt_stress.cpp.o.d"
+  "rt_stress"
+  "rt_stress.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/rt_stress.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,24 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/scheduler.cpp" "CMakeFiles/schd.dir/scheduler.cpp.o" "gcc" "CMakeFiles/schd.dir/scheduler.cpp.o.d"
+  "/root/repo/sharedwheel.cpp" "CMakeFiles/schd.dir/sharedwheel.cpp.o" "gcc" "CMakeFiles/schd.dir/sharedwheel.cpp.o.d"
+  "/root/repo/taskcost.cpp" "CMakeFiles/schd.dir/taskcost.cpp.o" "gcc" "CMakeFiles/schd.dir/taskcost.cpp.o.d"
+  "/root/repo/taskgraph.cpp" "CMakeFiles/schd.dir/taskgraph.cpp.o" "gcc" "CMakeFiles/schd.dir/taskgraph.cpp.o.d"
+  "/root/repo/tasktrace.cpp" "CMakeFiles/schd.dir/tasktrace.cpp.o" "gcc" "CMakeFiles/schd.dir/tasktrace.cpp.o.d"
+  "/root/repo/timerreplay.cpp" "CMakeFiles/schd.dir/timerreplay.cpp.o" "gcc" "CMakeFiles/schd.dir/timerreplay.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,21 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/schd.dir/scheduler.cpp.o"
+  "CMakeFiles/schd.dir/scheduler.cpp.o.d"
+  "CMakeFiles/schd.dir/sharedwheel.cpp.o"
+  "CMakeFiles/schd.dir/sharedwheel.cpp.o.d"
+  "CMakeFiles/schd.dir/taskcost.cpp.o"
+  "CMakeFiles/schd.dir/taskcost.cpp.o.d"
+  "CMakeFiles/schd.dir/taskgraph.cpp.o"
+  "CMakeFiles/schd.dir/taskgraph.cpp.o.d"
+  "CMakeFiles/schd.dir/tasktrace.cpp.o"
+  "CMakeFiles/schd.dir/tasktrace.cpp.o.d"
+  "CMakeFiles/schd.dir/timerreplay.cpp.o"
+  "CMakeFiles/schd.dir/timerreplay.cpp.o.d"
+  "libschd.a"
+  "libschd.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/schd.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
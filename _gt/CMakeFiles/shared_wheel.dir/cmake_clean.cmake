@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/shared_wheel.dir/tests/shared_wheel.cpp.o"
+  "CMakeFiles/shared_wheel.dir/tests/shared_wheel.cpp.o.d"
+  "shared_wheel"
+  "shared_wheel.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/shared_wheel.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/strand_fifo.dir/tests/strand_fifo.cpp.o"
+  "CMakeFiles/strand_fifo.dir/tests/strand_fifo.cpp.o.d"
+  "strand_fifo"
+  "strand_fifo.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/strand_fifo.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
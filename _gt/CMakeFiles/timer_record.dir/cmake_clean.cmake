@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/timer_record.dir/tests/timer_record.cpp.o"
+  "CMakeFiles/timer_record.dir/tests/timer_record.cpp.o.d"
+  "timer_record"
+  "timer_record.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/timer_record.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
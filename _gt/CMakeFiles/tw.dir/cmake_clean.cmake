@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/tw.dir/main.cpp.o"
+  "CMakeFiles/tw.dir/main.cpp.o.d"
+  "tw"
+  "tw.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/tw.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
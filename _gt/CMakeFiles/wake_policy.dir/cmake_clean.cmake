@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/wake_policy.dir/bench/wake_policy.cpp.o"
+  "CMakeFiles/wake_policy.dir/bench/wake_policy.cpp.o.d"
+  "wake_policy"
+  "wake_policy.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/wake_policy.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,18 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo
+# Build directory: /root/repo/_gt
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test([=[rt_stress]=] "/root/repo/_gt/rt_stress")
+set_tests_properties([=[rt_stress]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;41;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[shared_wheel]=] "/root/repo/_gt/shared_wheel")
+set_tests_properties([=[shared_wheel]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;45;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[numa_emulated]=] "/root/repo/_gt/numa_emulated")
+set_tests_properties([=[numa_emulated]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;49;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[timer_record]=] "/root/repo/_gt/timer_record")
+set_tests_properties([=[timer_record]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;53;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[strand_fifo]=] "/root/repo/_gt/strand_fifo")
+set_tests_properties([=[strand_fifo]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;57;add_test;/root/repo/CMakeLists.txt;0;")
+add_test([=[owner_cancel]=] "/root/repo/_gt/owner_cancel")
+set_tests_properties([=[owner_cancel]=] PROPERTIES  _BACKTRACE_TRIPLES "/root/repo/CMakeLists.txt;61;add_test;/root/repo/CMakeLists.txt;0;")
@@ -0,0 +1,87 @@
+// async timer throughput: 90 tasks armed per tick, one go(), then get() on
+// every result, through SCHD_ASYNC_TASK completions and through the
+// packaged_task and std::future wrapping they replaced; once with the worker
+// pool and once on a virtual clock, where go() runs them inline and only the
+// completion path is left
+#include "scheduler.h"
+#include <memory>
+
+constexpr int PER_TICK = 90;
+
+template <class Arm>
+static double run(Scheduler &tw, int rounds, Arm &&arm)
+{
+    long sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        sum += arm(tw);
+    }
+    auto spent = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (sum != static_cast<long>(rounds) * PER_TICK * (PER_TICK - 1) / 2)
+    {
+        printf("wrong sum %ld\n", sum);
+    }
+    return rounds * PER_TICK / spent / 1e6;
+}
+
+static long completions(Scheduler &tw)
+{
+    std::vector<Completion<int>> results;
+    results.reserve(PER_TICK);
+    for (int i = 0; i < PER_TICK; i++)
+    {
+        results.push_back(tw.set_task(RelativeTimeTick{0}, SCHD_ASYNC_TASK, [](int x) { return x; }, i));
+    }
+    tw.go();
+    long sum = 0;
+    for (auto &ele : results)
+    {
+        sum += ele.get();
+    }
+    return sum;
+}
+
+static long futures(Scheduler &tw)
+{
+    std::vector<std::future<int>> results;
+    results.reserve(PER_TICK);
+    for (int i = 0; i < PER_TICK; i++)
+    {
+        auto task = std::make_shared<std::packaged_task<int()>>(std::bind([](int x) { return x; }, i));
+        results.push_back(task->get_future());
+        tw.set_task(RelativeTimeTick{0}, TaskObj{0, 0, 0xFFFFFFFF, 1, [task]() { (*task)(); }});
+    }
+    tw.go();
+    long sum = 0;
+    for (auto &ele : results)
+    {
+        sum += ele.get();
+    }
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 2000;
+    {
+        Scheduler tw;
+        // the first rounds fill the completion pool and start the workers
+        run(tw, rounds / 10, completions);
+        run(tw, rounds / 10, futures);
+        auto future_rate = run(tw, rounds, futures);
+        auto completion_rate = run(tw, rounds, completions);
+        printf("pool     future %5.2fM/s completion %5.2fM/s %4.1fx\n", future_rate, completion_rate,
+               completion_rate / future_rate);
+    }
+    {
+        Scheduler tw(VirtualClock{});
+        run(tw, rounds / 10, completions);
+        run(tw, rounds / 10, futures);
+        auto future_rate = run(tw, rounds, futures);
+        auto completion_rate = run(tw, rounds, completions);
+        printf("inline   future %5.2fM/s completion %5.2fM/s %4.1fx\n", future_rate, completion_rate,
+               completion_rate / future_rate);
+    }
+    return 0;
+}
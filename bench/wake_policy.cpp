@@ -0,0 +1,61 @@
+// latency from go() to a due task starting, and process cpu share, for each
+// wake policy; a tick every 500us with 4 timers due on each
+#include "scheduler.h"
+#include <algorithm>
+#include <ctime>
+
+static int64_t clock_ns(clockid_t clock)
+{
+    timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t ticks = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000;
+    constexpr uint32_t PER_TICK = 4;
+    const char *names[] = {"park", "spin_park", "busy_poll"};
+    std::atomic<int64_t> go_at{0};
+    for (int policy = 0; policy < 3; policy++)
+    {
+        Scheduler tw;
+        tw.set_wake_policy(WakeConfig{static_cast<WakePolicy>(policy)});
+        std::vector<int64_t> latency;
+        latency.reserve(ticks * PER_TICK);
+        std::mutex latency_mtx;
+        auto record = [&]()
+        {
+            auto delay = clock_ns(CLOCK_MONOTONIC) - go_at.load();
+            std::lock_guard<std::mutex> grd(latency_mtx);
+            latency.push_back(delay);
+        };
+        for (uint32_t t = 1; t <= ticks; t++)
+        {
+            for (uint32_t k = 0; k < PER_TICK; k++)
+            {
+                tw.set_task(RelativeTimeTick{t}, TaskObj{0, 0, 0xFFFFFFFF, 1, record});
+            }
+        }
+        auto cpu_start = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+        auto wall_start = clock_ns(CLOCK_MONOTONIC);
+        for (uint32_t t = 0; t <= ticks; t++)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            go_at = clock_ns(CLOCK_MONOTONIC);
+            tw.go();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto cpu = clock_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+        auto wall = clock_ns(CLOCK_MONOTONIC) - wall_start;
+        std::lock_guard<std::mutex> grd(latency_mtx);
+        if (latency.empty())
+        {
+            continue;
+        }
+        std::sort(latency.begin(), latency.end());
+        printf("%-9s tasks %zu p50 %7.1fus p99 %7.1fus cpu %3.0f%%\n", names[policy], latency.size(),
+               latency[latency.size() / 2] / 1e3, latency[latency.size() * 99 / 100] / 1e3, 100.0 * cpu / wall);
+    }
+    return 0;
+}
@@ -0,0 +1,439 @@
+#ifndef USER_COMPLETION_HEADER
+#define USER_COMPLETION_HEADER
+
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+inline void futex_wait(std::atomic<uint32_t> &word, uint32_t expected)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected)
+    {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+inline void futex_wake(std::atomic<uint32_t> &word, int count)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)count;
+#endif
+}
+
+inline void futex_wake_all(std::atomic<uint32_t> &word)
+{
+    futex_wake(word, INT32_MAX);
+}
+
+// type erased view the worker uses to run or drop an async task
+class CompletionBase
+{
+public:
+    virtual void run() = 0;
+    virtual void abandon() = 0;
+
+protected:
+    ~CompletionBase() = default;
+};
+
+template <class T>
+class Completion;
+
+template <class T>
+class CompletionState : public CompletionBase
+{
+    friend class Completion<T>;
+
+    enum : uint32_t
+    {
+        PENDING = 0,
+        RUNNING = 1,
+        VALUE = 2,
+        ERROR = 3,
+        CANCELLED = 4,
+        STATUS_MASK = 7,
+        WAITERS = 8,
+        CONTINUED = 16
+    };
+
+    using value_type = std::conditional_t<std::is_void<T>::value, bool,
+                                          std::conditional_t<std::is_reference<T>::value,
+                                                             std::reference_wrapper<std::remove_reference_t<T>>, T>>;
+
+public:
+    void abandon() override
+    {
+        cancel();
+        release();
+    }
+
+protected:
+    ~CompletionState() = default;
+
+    virtual void destroy() = 0;
+
+    template <class Fn>
+    void execute(Fn &fn)
+    {
+        auto s = word.load(std::memory_order_acquire);
+        do
+        {
+            if ((s & STATUS_MASK) != PENDING)
+            {
+                return;
+            }
+        } while (!word.compare_exchange_weak(s, (s & ~STATUS_MASK) | RUNNING, std::memory_order_acq_rel));
+        uint32_t status = VALUE;
+        try
+        {
+            if constexpr (std::is_void<T>::value)
+            {
+                fn();
+                value.emplace(true);
+            }
+            else
+            {
+                value.emplace(fn());
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+            status = ERROR;
+        }
+        settle(word.exchange(status, std::memory_order_acq_rel));
+    }
+
+    bool cancel()
+    {
+        auto s = word.load(std::memory_order_acquire);
+        while ((s & STATUS_MASK) == PENDING)
+        {
+            if (word.compare_exchange_weak(s, CANCELLED, std::memory_order_acq_rel))
+            {
+                settle(s);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void acquire()
+    {
+        refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            destroy();
+        }
+    }
+
+private:
+    void settle(uint32_t old)
+    {
+        if (old & WAITERS)
+        {
+            futex_wake_all(word);
+        }
+        if (old & CONTINUED)
+        {
+            // the result is already published and waiters may be awake, so a
+            // throwing continuation is reported but cannot change it
+            acquire();
+            try
+            {
+                cont(Completion<T>(this));
+            }
+            catch (const std::exception &e)
+            {
+                printf("error: continuation: %s\n", e.what());
+            }
+            catch (...)
+            {
+                printf("error: continuation threw\n");
+            }
+        }
+    }
+
+    bool done() const
+    {
+        return (word.load(std::memory_order_acquire) & STATUS_MASK) >= VALUE;
+    }
+
+    void wait()
+    {
+        auto s = word.load(std::memory_order_acquire);
+        while ((s & STATUS_MASK) < VALUE)
+        {
+            if (!(s & WAITERS) && !word.compare_exchange_weak(s, s | WAITERS, std::memory_order_acq_rel))
+            {
+                continue;
+            }
+            futex_wait(word, s | WAITERS);
+            s = word.load(std::memory_order_acquire);
+        }
+    }
+
+    std::atomic<uint32_t> word{PENDING};
+    // one reference held by the scheduler side, one by the first Completion handle
+    std::atomic<uint32_t> refs{2};
+    std::optional<value_type> value;
+    std::exception_ptr error;
+    std::function<void(Completion<T>)> cont;
+};
+
+template <class T, class Fn>
+class BoundCompletion final : public CompletionState<T>
+{
+    // freed slots are kept per thread and handed to or taken from the shared
+    // list BATCH at a time, so the lock is taken once per batch, not per task
+    static constexpr size_t BATCH = 64;
+
+    struct pool
+    {
+        std::mutex mtx;
+        void *freelist{};
+
+        ~pool()
+        {
+            while (freelist != nullptr)
+            {
+                auto temp = freelist;
+                freelist = *static_cast<void **>(freelist);
+                ::operator delete(temp);
+            }
+        }
+    };
+
+    struct cache
+    {
+        void *freelist{};
+        size_t count{};
+
+        ~cache()
+        {
+            while (count != 0)
+            {
+                spill(count);
+            }
+        }
+
+        // hands count slots from the head of the local list to the shared one
+        void spill(size_t n)
+        {
+            auto first = freelist;
+            auto last = first;
+            for (size_t i = 1; i < n; i++)
+            {
+                last = *static_cast<void **>(last);
+            }
+            freelist = *static_cast<void **>(last);
+            count -= n;
+            auto &p = slots();
+            std::lock_guard<std::mutex> grd(p.mtx);
+            *static_cast<void **>(last) = p.freelist;
+            p.freelist = first;
+        }
+
+        void refill()
+        {
+            auto &p = slots();
+            std::lock_guard<std::mutex> grd(p.mtx);
+            while (p.freelist != nullptr && count < BATCH)
+            {
+                auto temp = p.freelist;
+                p.freelist = *static_cast<void **>(temp);
+                *static_cast<void **>(temp) = freelist;
+                freelist = temp;
+                count++;
+            }
+        }
+    };
+
+    static pool &slots()
+    {
+        static pool instance;
+        return instance;
+    }
+
+    static cache &local()
+    {
+        thread_local cache instance;
+        return instance;
+    }
+
+public:
+    explicit BoundCompletion(Fn &&f) : fn(std::move(f)) {}
+
+    void run() override
+    {
+        this->execute(fn);
+        this->release();
+    }
+
+    void *operator new(size_t size)
+    {
+        auto &c = local();
+        if (c.freelist == nullptr)
+        {
+            c.refill();
+            if (c.freelist == nullptr)
+            {
+                return ::operator new(size);
+            }
+        }
+        auto temp = c.freelist;
+        c.freelist = *static_cast<void **>(temp);
+        c.count--;
+        return temp;
+    }
+
+    void operator delete(void *ptr)
+    {
+        auto &c = local();
+        *static_cast<void **>(ptr) = c.freelist;
+        c.freelist = ptr;
+        if (++c.count > 2 * BATCH)
+        {
+            c.spill(BATCH);
+        }
+    }
+
+private:
+    void destroy() override
+    {
+        delete this;
+    }
+
+    Fn fn;
+};
+
+// move-only handle to the result of an async task, a lighter std::future
+template <class T>
+class Completion
+{
+public:
+    Completion() = default;
+
+    explicit Completion(CompletionState<T> *s) : state(s) {}
+
+    Completion(Completion &&other) noexcept : state(std::exchange(other.state, nullptr)) {}
+
+    Completion &operator=(Completion &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            state = std::exchange(other.state, nullptr);
+        }
+        return *this;
+    }
+
+    Completion(const Completion &) = delete;
+    Completion &operator=(const Completion &) = delete;
+
+    ~Completion()
+    {
+        reset();
+    }
+
+    bool valid() const
+    {
+        return state != nullptr;
+    }
+
+    bool ready() const
+    {
+        return state->done();
+    }
+
+    void wait() const
+    {
+        state->wait();
+    }
+
+    // prevents the task from running if it has not started yet
+    bool cancel()
+    {
+        return state->cancel();
+    }
+
+    T get()
+    {
+        state->wait();
+        switch (state->word.load(std::memory_order_acquire) & CompletionState<T>::STATUS_MASK)
+        {
+        case CompletionState<T>::ERROR:
+            std::rethrow_exception(state->error);
+        case CompletionState<T>::CANCELLED:
+            throw std::future_error(std::future_errc::broken_promise);
+        default:
+            break;
+        }
+        if constexpr (std::is_void<T>::value)
+        {
+            return;
+        }
+        else if constexpr (std::is_reference<T>::value)
+        {
+            return state->value->get();
+        }
+        else
+        {
+            return std::move(*state->value);
+        }
+    }
+
+    // fn(Completion<T>) runs on the worker that settles the task, or right
+    // here if it is already settled; only one continuation per task
+    template <class Fn>
+    void then(Fn &&fn)
+    {
+        state->cont = std::forward<Fn>(fn);
+        auto s = state->word.load(std::memory_order_acquire);
+        while ((s & CompletionState<T>::STATUS_MASK) < CompletionState<T>::VALUE)
+        {
+            if (state->word.compare_exchange_weak(s, s | CompletionState<T>::CONTINUED, std::memory_order_acq_rel))
+            {
+                return;
+            }
+        }
+        state->acquire();
+        state->cont(Completion<T>(state));
+    }
+
+private:
+    void reset()
+    {
+        if (state != nullptr)
+        {
+            state->release();
+            state = nullptr;
+        }
+    }
+
+    CompletionState<T> *state{};
+};
+#endif
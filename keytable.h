@@ -0,0 +1,144 @@
+#ifndef USER_KEYTABLE_HEADER
+#define USER_KEYTABLE_HEADER
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// open addressing table of Slot by a non-zero key, probed linearly; Slot has
+// a uint64_t key, 0 while never used, and live(), a used slot that is not
+// live is a tombstone; slot pointers stay valid until the next insert
+template <class Slot>
+class KeyTable
+{
+public:
+    Slot *find(uint64_t key)
+    {
+        if (slots.empty())
+        {
+            return nullptr;
+        }
+        auto mask = slots.size() - 1;
+        for (auto i = home(key, mask);; i = (i + 1) & mask)
+        {
+            auto &slot = slots[i];
+            if (slot.key == 0)
+            {
+                return nullptr;
+            }
+            if (slot.key == key && slot.live())
+            {
+                return &slot;
+            }
+        }
+    }
+
+    // the live slot of key, or a fresh one holding only key for the caller
+    // to bring to life
+    Slot *insert(uint64_t key)
+    {
+        if ((used + 1) * 2 > slots.size())
+        {
+            size_t live = 0;
+            for (auto &slot : slots)
+            {
+                live += slot.key != 0 && slot.live();
+            }
+            auto size = fit(live);
+            rehash(size > slots.size() ? size : slots.size());
+        }
+        auto mask = slots.size() - 1;
+        Slot *tombstone = nullptr;
+        for (auto i = home(key, mask);; i = (i + 1) & mask)
+        {
+            auto &slot = slots[i];
+            if (slot.key == key && slot.live())
+            {
+                return &slot;
+            }
+            if (slot.key != 0 && !slot.live() && tombstone == nullptr)
+            {
+                tombstone = &slot;
+            }
+            if (slot.key == 0)
+            {
+                auto fresh = tombstone != nullptr ? tombstone : &slot;
+                used += tombstone == nullptr;
+                *fresh = Slot{};
+                fresh->key = key;
+                return fresh;
+            }
+        }
+    }
+
+    // room for count live keys without allocating again; resizing rather
+    // than reserving faults the pages in up front
+    void reserve(size_t count)
+    {
+        auto size = fit(count);
+        if (slots.size() < size)
+        {
+            rehash(size);
+            scratch.assign(size, Slot{});
+        }
+    }
+
+    template <class Fn>
+    void for_each(Fn &&fn)
+    {
+        for (auto &slot : slots)
+        {
+            if (slot.key != 0 && slot.live())
+            {
+                fn(slot);
+            }
+        }
+    }
+
+private:
+    static size_t home(uint64_t key, size_t mask)
+    {
+        return (key * 0x9E3779B97F4A7C15ull) >> 32 & mask;
+    }
+
+    static size_t fit(size_t live)
+    {
+        size_t size = 16;
+        while (size < live * 4)
+        {
+            size *= 2;
+        }
+        return size;
+    }
+
+    // live keys only, which also clears tombstones; the scratch table keeps
+    // its capacity, so steady churn does not allocate
+    void rehash(size_t size)
+    {
+        scratch.assign(size, Slot{});
+        used = 0;
+        for (auto &slot : slots)
+        {
+            if (slot.key == 0 || !slot.live())
+            {
+                continue;
+            }
+            for (auto i = home(slot.key, size - 1);; i = (i + 1) & (size - 1))
+            {
+                if (scratch[i].key == 0)
+                {
+                    scratch[i] = slot;
+                    break;
+                }
+            }
+            used++;
+        }
+        slots.swap(scratch);
+    }
+
+private:
+    std::vector<Slot> slots;
+    std::vector<Slot> scratch;
+    size_t used{};
+};
+#endif
@@ -1,240 +1,2336 @@
 #include "scheduler.h"
+#include <limits>
+#include <new>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <time.h>
+#endif
+#if defined(SCHD_HAVE_NUMA)
+#include <numa.h>
+#endif
+
+static int64_t monotonic_ns()
+{
+#if defined(__linux__)
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
 
 Scheduler::lattice *Scheduler::lattice::freelist = nullptr;
 std::mutex Scheduler::lattice::mem_mtx = {};
 
-Scheduler::Scheduler(uint32_t current_time)
-    : currtick(current_time), workers(std::make_unique<Worker>(*this))
+// pool the calling thread belongs to and its NUMA node there
+static thread_local const Worker *pool_owner = nullptr;
+static thread_local uint32_t pool_group = 0;
+
+Scheduler::Scheduler(uint32_t current_time, std::chrono::nanoseconds resolution)
+    : Scheduler(current_time, resolution, false)
+{
+}
+
+Scheduler::Scheduler(VirtualClock, uint32_t current_time, std::chrono::nanoseconds resolution)
+    : Scheduler(current_time, resolution, true)
+{
+}
+
+Scheduler::Scheduler(const NumaConfig &config, uint32_t current_time, std::chrono::nanoseconds resolution)
+    : Scheduler(current_time, resolution, false, &config)
+{
+}
+
+Scheduler::Scheduler(uint32_t current_time, std::chrono::nanoseconds resolution, bool simulated,
+                     const NumaConfig *numa)
+    : currtick(current_time), tick_ns(resolution), virtual_time(simulated)
 {
-    for (size_t i = 0; i < TWR_SIZE; i++)
+    if (numa != nullptr)
     {
-        tw_1st[i] = new lattice;
-        lattice::set_init(tw_1st[i]);
+        build_topology(*numa);
+        pools = std::make_unique<node_pool[]>(topology.size());
+        group_threads = numa->threads;
     }
-    for (size_t j = 0; j < 4; j++)
+    else
     {
-        auto &headn = tw_nth[j];
-        for (size_t i = 0; i < TWN_SIZE; i++)
-        {
-            headn[i] = new lattice;
-            lattice::set_init(headn[i]);
-        }
+        topology.resize(1);
+    }
+    due = std::make_unique<due_list[]>(topology.size());
+    for (size_t i = 0; i < topology.size(); i++)
+    {
+        due[i].head = new lattice;
+        lattice::set_init(due[i].head);
+    }
+    init_wheel(WheelLayout{});
+    // last, its threads may claim from the wheel right away
+    workers = std::make_unique<Worker>(*this, !simulated);
+}
+
+Scheduler::Scheduler(const RealtimeConfig &config, uint32_t current_time, std::chrono::nanoseconds resolution)
+    : Scheduler(current_time, resolution)
+{
+    rt_config = config;
+    if (config.max_cascade != 0)
+    {
+        init_stage();
+    }
+    if (config.capacity == 0)
+    {
+        return;
+    }
+    // value-initialising the arena also faults every page in before mlock
+    arena = std::make_unique<lattice[]>(config.capacity);
+    for (size_t i = 0; i < config.capacity; i++)
+    {
+        arena[i].next = arena_free;
+        arena_free = &arena[i];
+    }
+#if defined(__linux__)
+    if (config.lock_memory)
+    {
+        locked = mlock(arena.get(), config.capacity * sizeof(lattice)) == 0;
     }
+#endif
+    // timers alone can then never grow the strand backlog, nor the owner and
+    // debounce/throttle tables
+    workers->reserve_strands(config.capacity);
+    owners.reserve(config.capacity);
+    keyed.reserve(config.capacity);
 }
 
 Scheduler::~Scheduler()
 {
-    for (size_t i = 0; i < TWR_SIZE; i++)
+    // stop the pool first so no worker re-inserts into a wheel being torn down
+    workers.reset();
+    for (auto head : tw_1st)
     {
-        lattice *head = tw_1st[i];
         while (head != head->next)
         {
             auto temp = head->next;
             temp->next->prev = temp->prev;
             temp->prev->next = temp->next;
-            temp->task = {};
-            delete temp;
+            if (temp->task.async)
+            {
+                temp->task.async->abandon();
+            }
+            free_lattice(temp);
         }
         delete head;
     }
-    for (size_t j = 0; j < 4; j++)
+    for (auto &level : tw_nth)
     {
-        auto &headn = tw_nth[j];
-        for (size_t i = 0; i < TWN_SIZE; i++)
+        for (auto head : level)
         {
-            lattice *head = headn[i];
             while (head != head->next)
             {
                 auto temp = head->next;
                 temp->next->prev = temp->prev;
                 temp->prev->next = temp->next;
-                temp->task = {};
-                delete temp;
+                if (temp->task.async)
+                {
+                    temp->task.async->abandon();
+                }
+                free_lattice(temp);
             }
             delete head;
         }
     }
-    lattice::free();
-}
-
-void Scheduler::go()
-{
-    std::lock_guard<std::mutex> grd(tw_mtx);
-    auto current_ticks = currtick.fetch_add(1, std::memory_order_release);
-    auto index = FST_IDX(current_ticks);
-    if (index == 0)
+    for (auto head : stage_1st)
     {
-        uint32_t i = 0;
-        uint32_t tpx;
-        do
+        while (head != head->next)
         {
-            tpx = NTH_IDX(currtick, i);
-            move_lattice_cascade(tw_nth[i][tpx], current_ticks);
-
-        } while (tpx == 0 && ++i < 4);
+            auto temp = head->next;
+            temp->next->prev = temp->prev;
+            temp->prev->next = temp->next;
+            if (temp->task.async)
+            {
+                temp->task.async->abandon();
+            }
+            free_lattice(temp);
+        }
+        delete head;
     }
-    lattice *head = tw_1st[index];
-    while (head && head != head->next)
+    for (auto &level : stage_nth)
     {
-        auto temp = head->next;
-        workers->submit(std::move(temp->task));
-        temp->next->prev = temp->prev;
-        temp->prev->next = temp->next;
-        temp->task = {};
-        delete temp;
+        for (auto head : level)
+        {
+            while (head != head->next)
+            {
+                auto temp = head->next;
+                temp->next->prev = temp->prev;
+                temp->prev->next = temp->next;
+                if (temp->task.async)
+                {
+                    temp->task.async->abandon();
+                }
+                free_lattice(temp);
+            }
+            delete head;
+        }
     }
-}
-
-Scheduler::lattice *Scheduler::calculate_lattice(uint32_t ticks, uint32_t current_ticks)
-{
-    auto expired_tick = current_ticks + ticks;
-    lattice *head{};
-    if (ticks < TWR_SIZE)
+    for (size_t i = 0; i < topology.size(); i++)
     {
-        head = tw_1st[FST_IDX(expired_tick)];
+        auto head = due[i].head;
+        while (head != head->next)
+        {
+            auto temp = head->next;
+            temp->next->prev = temp->prev;
+            temp->prev->next = temp->next;
+            if (temp->task.async)
+            {
+                temp->task.async->abandon();
+            }
+            free_lattice(temp);
+        }
+        delete head;
     }
-    else
+    lattice::free();
+    for (size_t i = 0; pools && i < topology.size(); i++)
     {
-        for (size_t i = 0; i < 4; i++)
+        for (auto mem : pools[i].slabs)
         {
-            uint64_t sz = 1ull << (TWR_BITS + (i + 1) * TWN_BITS);
-            if (ticks < sz)
+            auto nodes = static_cast<lattice *>(mem);
+            for (size_t j = 0; j < SLAB; j++)
             {
-                head = tw_nth[i][NTH_IDX(expired_tick, i)];
-                break;
+                nodes[j].~lattice();
             }
+#if defined(__linux__)
+            munmap(mem, SLAB * sizeof(lattice));
+#else
+            ::operator delete(mem);
+#endif
         }
     }
-    return head;
+#if defined(__linux__)
+    if (locked)
+    {
+        munlock(arena.get(), rt_config.capacity * sizeof(lattice));
+    }
+    if (timer_fd >= 0)
+    {
+        close(timer_fd);
+    }
+#endif
 }
 
-void Scheduler::move_lattice_cascade(lattice *head, uint32_t current_ticks)
+void Scheduler::go()
 {
-    while (head != head->next)
+    tick_once();
+    if (virtual_time)
     {
-        lattice *temp = head->next;
-        temp->next->prev = temp->prev;
-        temp->prev->next = temp->next;
-        auto pos = calculate_lattice(temp->task.expired - current_ticks, current_ticks);
-        temp->prev = pos->prev;
-        temp->next = pos;
-        temp->prev->next = temp;
-        head->prev = temp;
+        // run here once the wheel lock is released, so tasks may re-arm
+        workers->run_inline();
     }
 }
 
-void Scheduler::insert_lattice(uint32_t ticks, lattice *node, char isRelative)
+void Scheduler::set_wake_policy(const WakeConfig &config)
 {
-    std::lock_guard<std::mutex> grd(tw_mtx);
-    auto current_ticks = currtick.load(std::memory_order_acquire);
-    if (isRelative == 'a' && ticks < current_ticks)
-    {
-        return;
-    }
-    uint32_t relative_ticks;
-    switch (isRelative)
+    workers->spin_polls.store(config.spin, std::memory_order_relaxed);
+    workers->yield_polls.store(config.yield, std::memory_order_relaxed);
+    workers->policy.store(config.policy, std::memory_order_relaxed);
+}
+
+uint32_t Scheduler::advance(uint32_t ticks)
+{
+    uint32_t processed = 0;
+    while (ticks != 0)
     {
-    case 'r':
-        relative_ticks = ticks;
-        break;
-    case 'a':
-        relative_ticks = ticks - current_ticks;
-        break;
-    case 'c':
-        relative_ticks = (currtick / ticks + 1) * ticks - currtick + 1;
-        break;
-    default:
-        return;
+        ticks -= skip_idle(ticks - 1) + 1;
+        go();
+        processed++;
     }
-    node->task.expired = current_ticks + relative_ticks;
-    auto head = calculate_lattice(relative_ticks, current_ticks);
-    node->prev = head->prev;
-    node->next = head;
-    node->prev->next = node;
-    head->prev = node;
+    return processed;
 }
 
-Worker::Worker(Scheduler &_tw)
-    : queue(std::make_unique<TaskObj[]>(MAX_SIZE)),
-      front(1), rear(0), stop(false), tw(_tw)
+bool Scheduler::step()
 {
-    for (size_t i = 0; i < 2; i++)
     {
-        thd.emplace_back(&Worker::do_work, this);
+        std::lock_guard<std::mutex> grd(tw_mtx);
+        if (wheel_empty())
+        {
+            return false;
+        }
     }
+    skip_idle(std::numeric_limits<uint32_t>::max());
+    go();
+    return true;
 }
 
-Worker::~Worker()
+uint32_t Scheduler::skip_idle(uint32_t limit)
 {
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    auto current_ticks = currtick.load(std::memory_order_acquire);
+    // upper levels only hold timers due after the next first level wrap, and
+    // that wrap must be processed to cascade them, so only the first level
+    // slots up to it are looked at
+    auto wrap = (fst_mask + 1 - FST_IDX(current_ticks)) & fst_mask;
+    uint32_t jump = 0;
+    while (jump < wrap && jump < limit && slot_empty(FST_IDX(current_ticks + jump)) &&
+           stage_empty(FST_IDX(current_ticks + jump)))
     {
-        std::lock_guard<std::mutex> grd(mtx);
-        stop = true;
+        jump++;
     }
-    cond.notify_all();
-    for (auto &ele : thd)
+    if (jump == wrap && jump < limit && wheel_empty())
     {
-        ele.join();
+        jump = limit;
     }
+    currtick.store(current_ticks + jump, std::memory_order_release);
+    return jump;
 }
 
-bool Worker::submit(TaskObj &&obj)
+bool Scheduler::wheel_empty() const
 {
+    for (auto head : tw_1st)
     {
-        std::lock_guard<std::mutex> grd(mtx);
-        if (stop)
+        if (head != head->next)
         {
             return false;
         }
-        if ((rear + 2) % MAX_SIZE == front)
+    }
+    for (auto &level : tw_nth)
+    {
+        for (auto head : level)
+        {
+            if (head != head->next)
+            {
+                return false;
+            }
+        }
+    }
+    for (auto head : stage_1st)
+    {
+        if (head != head->next)
         {
             return false;
         }
-        rear = (rear + 1) % MAX_SIZE;
-        queue[rear] = obj;
     }
-    cond.notify_one();
+    for (auto &level : stage_nth)
+    {
+        for (auto head : level)
+        {
+            if (head != head->next)
+            {
+                return false;
+            }
+        }
+    }
     return true;
 }
 
-void Worker::do_work()
+void Scheduler::tick_once()
 {
-    for (;;)
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    auto current_ticks = currtick.fetch_add(1, std::memory_order_release);
+    auto index = FST_IDX(current_ticks);
+    tick_moves = 0;
+    if (pools)
     {
-        TaskObj task;
+        tick_group = caller_group();
+    }
+    if (index == 0)
+    {
+        uint32_t i = 0;
+        uint32_t tpx;
+        do
         {
-            std::unique_lock<std::mutex> lck(mtx);
-            cond.wait(lck, [this]()
-                      { return stop || (length() != 0); });
-            if (stop && length() == 0)
+            tpx = NTH_IDX(currtick, i);
+            move_lattice_cascade(tw_nth[i][tpx], current_ticks);
+            if (!stage_nth.empty())
             {
-                return;
+                // the slot now holds its next lap, including what was refined ahead
+                splice_lattice(stage_nth[i][tpx], tw_nth[i][tpx]);
             }
-            task = std::move(queue[front]);
-            front = (front + 1) % MAX_SIZE;
+        } while (tpx == 0 && ++i < tw_nth.size());
+    }
+    // each NUMA node has its own list in the slot, so every list leaves in
+    // O(1) for the due list of its node and the pool claims it chunk by chunk
+    for (uint32_t i = 0; i < topology.size(); i++)
+    {
+        lattice *head = tw_1st[fst_slot(index, i)];
+        if (head != head->next)
+        {
+            due[i].marks[current_ticks % TICK_MARKS] = tick_mark{current_ticks, SCHD_TRACE_STAMP()};
+            splice_lattice(head, due[i].head);
+            due[i].ready.store(true, std::memory_order_release);
+            workers->notify(workers->per_group, i);
         }
-        task.started = tw.now();
-        try
+    }
+    lattice *head = tw_1st[fst_slot(index, topology.size())];
+    if (head != head->next)
+    {
+        hand_precise(head, current_ticks);
+    }
+    if (!stage_1st.empty())
+    {
+        for (uint32_t i = 0; i <= topology.size(); i++)
         {
-            task.func();
+            splice_lattice(stage_1st[fst_slot(index, i)], tw_1st[fst_slot(index, i)]);
+        }
+        cascade_ahead(current_ticks);
+    }
+    peak_moves = std::max(peak_moves, tick_moves);
+}
+
+void Scheduler::hand_precise(lattice *head, uint32_t current_ticks)
+{
+    // the tick starts now for every one of them, however late the pool
+    // gets to the rest of the slot
+    auto start_ns = tick_start_ns(current_ticks);
+    // appended at the tail, so the stable sort keeps tied offsets in list order
+    lattice *precise = nullptr;
+    lattice *precise_tail = nullptr;
+    while (head != head->next)
+    {
+        auto temp = head->next;
+        temp->next->prev = temp->prev;
+        temp->prev->next = temp->next;
+        if (temp->task.rate_class != 0 && !take_token(temp, current_ticks))
+        {
+            continue;
+        }
+        unlink_owner(temp);
+        temp->deadline = start_ns + temp->task.subtick;
+        samples.fired++;
+        SCHD_TRACE(DISPATCH, temp->task.trace_id, current_ticks, 0);
+        temp->next = nullptr;
+        (precise_tail != nullptr ? precise_tail->next : precise) = temp;
+        precise_tail = temp;
+    }
+    if (precise != nullptr)
+    {
+        precise = sort_deadline(precise);
+        auto last = precise;
+        while (last->next != nullptr)
+        {
+            last = last->next;
         }
-        catch (const std::exception &e)
+        workers->submit_precise(precise, last);
+    }
+}
+
+bool Scheduler::slot_empty(uint32_t index) const
+{
+    for (uint32_t i = 0; i <= topology.size(); i++)
+    {
+        auto head = tw_1st[fst_slot(index, i)];
+        if (head != head->next)
         {
-            printf("error: %s\n", e.what());
-            throw e;
+            return false;
         }
-        auto exceed_ticks = tw.now() - task.started;
-        auto penalty_ticks = task.duration != 0 ? task.duration - 1 : task.duration;
-        if (task.duration != 0 && exceed_ticks > task.duration)
+    }
+    return true;
+}
+
+size_t Scheduler::claim_due(TaskObj *out, size_t max, uint32_t group)
+{
+    auto &list = due[group];
+    if (!list.ready.load(std::memory_order_acquire))
+    {
+        return 0;
+    }
+    if (rt_config.max_dispatch != 0)
+    {
+        max = std::min<size_t>(max, rt_config.max_dispatch);
+    }
+    size_t count = 0;
+    lattice *spent = nullptr;
+    {
+        std::lock_guard<std::mutex> grd(tw_mtx);
+        // the tick go() last processed, throttle windows restart from it
+        auto current_ticks = currtick.load(std::memory_order_acquire) - 1;
+        // strands are taken in list order while the wheel lock is held, so a
+        // chunk claimed by another thread can never overtake a follower still
+        // sitting in this one
+        std::unique_lock<std::mutex> strand_lck(workers->mtx, std::defer_lock);
+        while (count < max && list.head != list.head->next)
         {
-            penalty_ticks += exceed_ticks;
-            if (task.hand)
+            auto temp = list.head->next;
+            temp->next->prev = temp->prev;
+            temp->prev->next = temp->next;
+            if (temp->task.rate_class != 0 && !take_token(temp, current_ticks))
+            {
+                continue;
+            }
+            if (temp->keyed != 0 && !temp->task.func)
+            {
+                // a throttle window closing with nothing queued behind it
+                release_keyed(temp, current_ticks, false);
+                continue;
+            }
+            SCHD_TRACE_AT(DISPATCH, temp->task.trace_id, current_ticks, 0, spliced_stamp(temp->task.expired, list));
+            samples.fired++;
+            if (temp->task.strand != 0 && !workers->inline_mode)
+            {
+                if (!strand_lck.owns_lock())
+                {
+                    strand_lck.lock();
+                }
+                if (workers->claim_strand(temp->task))
+                {
+                    out[count++] = std::move(temp->task);
+                }
+            }
+            else
+            {
+                out[count++] = std::move(temp->task);
+            }
+            if (temp->keyed != 0)
             {
-                task.hand(exceed_ticks, task.counters);
+                release_keyed(temp, current_ticks, true);
+                continue;
             }
+            unlink_owner(temp);
+            temp->next = spent;
+            spent = temp;
+        }
+        if (strand_lck.owns_lock())
+        {
+            strand_lck.unlock();
         }
-        if (--task.counters != 0)
+        if (list.head == list.head->next)
         {
-            tw.insert_lattice(penalty_ticks, new Scheduler::lattice{nullptr, nullptr, std::move(task)});
+            list.ready.store(false, std::memory_order_relaxed);
         }
     }
-}
\ No newline at end of file
+    free_chain(spent);
+    return count;
+}
+
+int64_t Scheduler::tick_start_ns(uint32_t tick) const
+{
+    // with an armed timerfd the tick boundary is known exactly, otherwise
+    // the call to go() marks it
+    if (virtual_time)
+    {
+        return static_cast<int64_t>(tick) * tick_ns.count();
+    }
+    if (timer_fd >= 0)
+    {
+        return epoch_ns + static_cast<int64_t>(tick - epoch_tick) * tick_ns.count();
+    }
+    return monotonic_ns();
+}
+
+uint64_t Scheduler::spliced_stamp(uint32_t tick, const due_list &list) const
+{
+    // a node claimed more than TICK_MARKS ticks late shows up as queued from now
+    auto &mark = list.marks[tick % TICK_MARKS];
+    return mark.tick == tick && mark.stamp != 0 ? mark.stamp : SCHD_TRACE_STAMP();
+}
+
+bool Scheduler::take_token(lattice *node, uint32_t current_ticks)
+{
+    auto cls = node->task.rate_class;
+    if (cls >= rate_buckets.size() || rate_buckets[cls].per_tick == 0 || (node->keyed != 0 && !node->task.func))
+    {
+        return true;
+    }
+    auto &bucket = rate_buckets[cls];
+    if (bucket.refill_tick != current_ticks)
+    {
+        auto refill = static_cast<uint64_t>(current_ticks - bucket.refill_tick) * bucket.per_tick;
+        bucket.tokens = static_cast<uint32_t>(std::min<uint64_t>(bucket.burst, bucket.tokens + refill));
+        bucket.refill_tick = current_ticks;
+    }
+    if (bucket.tokens != 0)
+    {
+        bucket.tokens--;
+        bucket.released++;
+        return true;
+    }
+    // turned away tasks fill later ticks per_tick at a time, so a storm is
+    // laid out over the wheel once instead of being retried every tick
+    auto next_tick = current_ticks + 1;
+    if (static_cast<int32_t>(bucket.cursor_tick - next_tick) < 0)
+    {
+        bucket.cursor_tick = next_tick;
+        bucket.cursor_used = 0;
+    }
+    if (bucket.cursor_used == bucket.per_tick)
+    {
+        bucket.cursor_tick++;
+        bucket.cursor_used = 0;
+    }
+    bucket.cursor_used++;
+    bucket.deferred++;
+    auto start_ticks = currtick.load(std::memory_order_relaxed);
+    link_lattice(node, bucket.cursor_tick - start_ticks, start_ticks);
+    return false;
+}
+
+void Scheduler::set_rate_limit(uint32_t cls, uint32_t per_tick, uint32_t burst)
+{
+    if (cls == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    if (cls >= rate_buckets.size())
+    {
+        rate_buckets.resize(cls + 1);
+    }
+    auto &bucket = rate_buckets[cls];
+    bucket.per_tick = per_tick;
+    bucket.burst = std::max(burst, per_tick);
+    bucket.tokens = bucket.burst;
+    bucket.refill_tick = currtick.load(std::memory_order_acquire);
+}
+
+RateStats Scheduler::rate_stats(uint32_t cls)
+{
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    if (cls >= rate_buckets.size())
+    {
+        return {};
+    }
+    return {rate_buckets[cls].released, rate_buckets[cls].deferred};
+}
+
+void Scheduler::start_wheel_profile()
+{
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    samples = wheel_samples{};
+    samples.on = true;
+}
+
+void Scheduler::stop_wheel_profile()
+{
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    samples.on = false;
+}
+
+WheelLayout Scheduler::wheel_layout()
+{
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    return {fst_bits, nth_bits, static_cast<uint32_t>(tw_nth.size())};
+}
+
+bool Scheduler::layout_valid(const WheelLayout &layout)
+{
+    if (layout.fst_bits < 4 || layout.fst_bits > 16 || layout.nth_bits < 2 || layout.nth_bits > 12 ||
+        layout.levels < 1 || layout.levels > 8)
+    {
+        return false;
+    }
+    // every 32 bit tick distance must fit, and no level may sit entirely above it
+    auto reach = layout.fst_bits + layout.levels * layout.nth_bits;
+    return reach >= 32 && reach - layout.nth_bits < 32;
+}
+
+double Scheduler::layout_cost(const WheelLayout &layout, const uint64_t *armed, const uint64_t *cancelled)
+{
+    uint64_t kept = 0;
+    uint64_t moved = 0;
+    for (size_t b = 0; b < SPANS; b++)
+    {
+        auto count = armed[b] - std::min(armed[b], cancelled[b]);
+        // level bounds are powers of two as well, so a bucket never straddles one
+        uint64_t low = b == 0 ? 0 : 1ull << (b - 1);
+        uint32_t level = 0;
+        while (level < layout.levels && low >= (1ull << (layout.fst_bits + level * layout.nth_bits)))
+        {
+            level++;
+        }
+        // at most one move per level on the way down to the first one
+        moved += count * level;
+        kept += count;
+    }
+    return kept == 0 ? 0.0 : static_cast<double>(moved) / kept;
+}
+
+WheelProfile Scheduler::wheel_profile()
+{
+    // slot heads a recommendation may use, about 1 MiB of sentinels
+    constexpr size_t HEAD_BUDGET = 4096;
+    WheelProfile report{};
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    std::copy(std::begin(samples.armed), std::end(samples.armed), report.armed);
+    std::copy(std::begin(samples.cancelled), std::end(samples.cancelled), report.cancelled);
+    report.fired = samples.fired;
+    report.observed_cost = samples.fired == 0 ? 0.0 : static_cast<double>(samples.moved) / samples.fired;
+    report.current = {fst_bits, nth_bits, static_cast<uint32_t>(tw_nth.size())};
+    report.current_cost = layout_cost(report.current, report.armed, report.cancelled);
+    auto heads = [](const WheelLayout &layout)
+    {
+        return (size_t{1} << layout.fst_bits) + layout.levels * (size_t{1} << layout.nth_bits);
+    };
+    // cheapest cascading first, then among layouts within 5% of it the one
+    // with the fewest slot heads, so timers that are mostly cancelled end up
+    // in coarse slots instead of buying a finer first level
+    std::vector<std::pair<WheelLayout, double>> candidates;
+    auto lowest = report.current_cost;
+    for (uint32_t fst = 6; fst <= 12; fst++)
+    {
+        for (uint32_t nth = 3; nth <= 10; nth++)
+        {
+            WheelLayout layout{fst, nth, (32 - fst + nth - 1) / nth};
+            if (!layout_valid(layout) || heads(layout) > HEAD_BUDGET)
+            {
+                continue;
+            }
+            auto cost = layout_cost(layout, report.armed, report.cancelled);
+            candidates.emplace_back(layout, cost);
+            lowest = std::min(lowest, cost);
+        }
+    }
+    auto tolerance = lowest * 1.05 + 0.01;
+    report.recommended = report.current;
+    report.recommended_cost = report.current_cost;
+    auto fewest = report.current_cost <= tolerance ? heads(report.current) : std::numeric_limits<size_t>::max();
+    for (auto &[layout, cost] : candidates)
+    {
+        if (cost <= tolerance && heads(layout) < fewest)
+        {
+            fewest = heads(layout);
+            report.recommended = layout;
+            report.recommended_cost = cost;
+        }
+    }
+    return report;
+}
+
+void Scheduler::init_wheel(const WheelLayout &layout)
+{
+    fst_bits = layout.fst_bits;
+    nth_bits = layout.nth_bits;
+    fst_mask = (1u << fst_bits) - 1;
+    nth_mask = (1u << nth_bits) - 1;
+    tw_1st.assign((size_t{1} << fst_bits) * (topology.size() + 1), nullptr);
+    for (auto &head : tw_1st)
+    {
+        head = new lattice;
+        lattice::set_init(head);
+    }
+    tw_nth.assign(layout.levels, std::vector<lattice *>(size_t{1} << nth_bits));
+    for (auto &level : tw_nth)
+    {
+        for (auto &head : level)
+        {
+            head = new lattice;
+            lattice::set_init(head);
+        }
+    }
+    if (rt_config.max_cascade != 0)
+    {
+        init_stage();
+    }
+}
+
+void Scheduler::init_stage()
+{
+    stage_1st.assign(tw_1st.size(), nullptr);
+    for (auto &head : stage_1st)
+    {
+        head = new lattice;
+        lattice::set_init(head);
+    }
+    stage_nth.assign(tw_nth.size(), std::vector<lattice *>(size_t{1} << nth_bits));
+    for (auto &level : stage_nth)
+    {
+        for (auto &head : level)
+        {
+            head = new lattice;
+            lattice::set_init(head);
+        }
+    }
+}
+
+bool Scheduler::stage_empty(uint32_t index) const
+{
+    if (stage_1st.empty())
+    {
+        return true;
+    }
+    for (uint32_t i = 0; i <= topology.size(); i++)
+    {
+        auto head = stage_1st[fst_slot(index, i)];
+        if (head != head->next)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Scheduler::rebuild_wheel(const WheelLayout &layout)
+{
+    if (!layout_valid(layout))
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    auto current_ticks = currtick.load(std::memory_order_acquire);
+    // nearest slots first, so timers due on the same tick keep their order
+    auto pending = new lattice;
+    lattice::set_init(pending);
+    for (uint32_t i = 0; i <= fst_mask; i++)
+    {
+        for (uint32_t j = 0; j <= topology.size(); j++)
+        {
+            splice_lattice(tw_1st[fst_slot(FST_IDX(current_ticks + i), j)], pending);
+        }
+    }
+    for (uint32_t i = 0; !stage_1st.empty() && i <= fst_mask; i++)
+    {
+        for (uint32_t j = 0; j <= topology.size(); j++)
+        {
+            splice_lattice(stage_1st[fst_slot(FST_IDX(current_ticks + i), j)], pending);
+        }
+    }
+    for (size_t j = 0; j < tw_nth.size(); j++)
+    {
+        auto base = NTH_IDX(current_ticks, j);
+        for (uint32_t i = 0; i <= nth_mask; i++)
+        {
+            splice_lattice(tw_nth[j][(base + i) & nth_mask], pending);
+            if (!stage_nth.empty())
+            {
+                splice_lattice(stage_nth[j][(base + i) & nth_mask], pending);
+            }
+        }
+    }
+    for (auto head : tw_1st)
+    {
+        delete head;
+    }
+    for (auto &level : tw_nth)
+    {
+        for (auto head : level)
+        {
+            delete head;
+        }
+    }
+    for (auto head : stage_1st)
+    {
+        delete head;
+    }
+    for (auto &level : stage_nth)
+    {
+        for (auto head : level)
+        {
+            delete head;
+        }
+    }
+    init_wheel(layout);
+    // expiries stay as they are, so the timerfd needs no re-arm
+    while (pending != pending->next)
+    {
+        auto temp = pending->next;
+        temp->next->prev = temp->prev;
+        temp->prev->next = temp->next;
+        auto ticks = temp->task.expired - current_ticks;
+        auto pos = calculate_lattice(static_cast<int32_t>(ticks) > 0 ? ticks : 0, current_ticks, temp);
+        temp->prev = pos->prev;
+        temp->next = pos;
+        temp->prev->next = temp;
+        pos->prev = temp;
+    }
+    delete pending;
+    return true;
+}
+
+Scheduler::lattice *Scheduler::sort_deadline(lattice *first)
+{
+    // merge sort over the next links, stable so equal deadlines keep insertion order
+    if (first == nullptr || first->next == nullptr)
+    {
+        return first;
+    }
+    auto slow = first;
+    auto fast = first->next;
+    while (fast != nullptr && fast->next != nullptr)
+    {
+        slow = slow->next;
+        fast = fast->next->next;
+    }
+    auto second = slow->next;
+    slow->next = nullptr;
+    first = sort_deadline(first);
+    second = sort_deadline(second);
+    lattice head;
+    auto tail = &head;
+    while (first != nullptr && second != nullptr)
+    {
+        auto &pick = second->deadline < first->deadline ? second : first;
+        tail->next = pick;
+        tail = pick;
+        pick = pick->next;
+    }
+    tail->next = first != nullptr ? first : second;
+    return head.next;
+}
+
+void Scheduler::enable_profiling(std::chrono::nanoseconds budget)
+{
+    for (auto &ele : workers->costs)
+    {
+        if (ele.load(std::memory_order_acquire) == nullptr)
+        {
+            CostTable *expected = nullptr;
+            auto table = new CostTable;
+            if (!ele.compare_exchange_strong(expected, table, std::memory_order_acq_rel))
+            {
+                delete table;
+            }
+        }
+    }
+    workers->budget_ns.store(budget.count(), std::memory_order_relaxed);
+    workers->profiling.store(true, std::memory_order_relaxed);
+}
+
+void Scheduler::disable_profiling()
+{
+    workers->profiling.store(false, std::memory_order_relaxed);
+}
+
+std::vector<TaskCost> Scheduler::top_costs(size_t n) const
+{
+    std::vector<const CostTable *> tables;
+    for (auto &ele : workers->costs)
+    {
+        if (auto table = ele.load(std::memory_order_acquire))
+        {
+            tables.push_back(table);
+        }
+    }
+    return CostTable::top(tables, n);
+}
+
+bool Scheduler::enter_tick_thread() const
+{
+#if defined(__linux__)
+    bool ok = true;
+    if (rt_config.tick_cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(rt_config.tick_cpu, &set);
+        ok = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 && ok;
+    }
+    if (rt_config.tick_priority > 0)
+    {
+        sched_param param{};
+        param.sched_priority = rt_config.tick_priority;
+        ok = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 && ok;
+    }
+    return ok;
+#else
+    return rt_config.tick_cpu < 0 && rt_config.tick_priority <= 0;
+#endif
+}
+
+void Scheduler::splice_lattice(lattice *from, lattice *to)
+{
+    if (from == from->next)
+    {
+        return;
+    }
+    auto first = from->next;
+    auto last = from->prev;
+    first->prev = to->prev;
+    to->prev->next = first;
+    last->next = to;
+    to->prev = last;
+    lattice::set_init(from);
+}
+
+Scheduler::lattice *Scheduler::alloc_lattice(TaskObj &&obj)
+{
+    if (pools)
+    {
+        return alloc_pooled(std::move(obj));
+    }
+    if (!arena)
+    {
+        return new lattice{nullptr, nullptr, std::move(obj)};
+    }
+    lattice *node;
+    {
+        std::lock_guard<std::mutex> grd(arena_mtx);
+        if (arena_free == nullptr)
+        {
+            return nullptr;
+        }
+        node = arena_free;
+        arena_free = arena_free->next;
+    }
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->keyed = 0;
+    node->span = 0xFF;
+    node->task = std::move(obj);
+    return node;
+}
+
+void Scheduler::free_chain(lattice *first)
+{
+    if (first == nullptr)
+    {
+        return;
+    }
+    auto last = first;
+    for (auto temp = first; temp != nullptr; temp = temp->next)
+    {
+        temp->task = {};
+        temp->owner_prev = nullptr;
+        temp->owner_next = nullptr;
+        last = temp;
+    }
+    if (pools)
+    {
+        release_pooled(first);
+        return;
+    }
+    if (!arena)
+    {
+        lattice::recycle(first, last);
+        return;
+    }
+    std::lock_guard<std::mutex> grd(arena_mtx);
+    last->next = arena_free;
+    arena_free = first;
+}
+
+void Scheduler::free_lattice(lattice *node)
+{
+    node->task = {};
+    if (pools)
+    {
+        node->owner_prev = nullptr;
+        node->owner_next = nullptr;
+        node->next = nullptr;
+        release_pooled(node);
+        return;
+    }
+    if (!arena)
+    {
+        delete node;
+        return;
+    }
+    node->owner_prev = nullptr;
+    node->owner_next = nullptr;
+    std::lock_guard<std::mutex> grd(arena_mtx);
+    node->next = arena_free;
+    arena_free = node;
+}
+
+void Scheduler::build_topology(const NumaConfig &config)
+{
+    std::vector<int> allowed;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+#endif
+#if defined(SCHD_HAVE_NUMA)
+    if (config.nodes == 0 && numa_available() >= 0)
+    {
+        // nodes without a usable cpu get no group, their memory stays unused
+        auto mask = numa_allocate_cpumask();
+        for (int node = 0; node <= numa_max_node(); node++)
+        {
+            if (numa_node_to_cpus(node, mask) != 0)
+            {
+                continue;
+            }
+            numa_group group{node, {}};
+            for (auto cpu : allowed)
+            {
+                if (numa_bitmask_isbitset(mask, cpu))
+                {
+                    group.cpus.push_back(cpu);
+                }
+            }
+            if (!group.cpus.empty())
+            {
+                topology.push_back(std::move(group));
+            }
+        }
+        numa_free_cpumask(mask);
+    }
+#endif
+    if (topology.empty())
+    {
+        // emulated nodes share cpus when there are fewer cpus than nodes, and
+        // their memory goes round robin to the real nodes
+        topology.resize(std::max<uint32_t>(config.nodes, 1));
+        auto nodes = topology.size();
+        for (size_t i = 0; !allowed.empty() && i < std::max(allowed.size(), nodes); i++)
+        {
+            topology[i % nodes].cpus.push_back(allowed[i % allowed.size()]);
+        }
+#if defined(SCHD_HAVE_NUMA)
+        if (numa_available() >= 0)
+        {
+            auto real = std::max(numa_num_configured_nodes(), 1);
+            for (size_t i = 0; i < nodes; i++)
+            {
+                topology[i].node = static_cast<int>(i) % real;
+            }
+        }
+#endif
+    }
+    for (uint32_t i = 0; i < topology.size(); i++)
+    {
+        for (auto cpu : topology[i].cpus)
+        {
+            if (static_cast<size_t>(cpu) >= cpu_group.size())
+            {
+                cpu_group.resize(cpu + 1, ~0u);
+            }
+            if (cpu_group[cpu] == ~0u)
+            {
+                cpu_group[cpu] = i;
+            }
+        }
+    }
+}
+
+uint32_t Scheduler::caller_group() const
+{
+    // pool threads may share a cpu with other nodes when emulated, so they go by their group
+    if (pool_owner == workers.get() && pool_owner != nullptr)
+    {
+        return pool_group;
+    }
+#if defined(__linux__)
+    auto cpu = sched_getcpu();
+    if (cpu >= 0 && static_cast<size_t>(cpu) < cpu_group.size() && cpu_group[cpu] != ~0u)
+    {
+        return cpu_group[cpu];
+    }
+#endif
+    return 0;
+}
+
+Scheduler::lattice *Scheduler::alloc_pooled(TaskObj &&obj)
+{
+    auto group = obj.home < topology.size() ? obj.home : caller_group();
+    obj.home = group;
+    auto &pool = pools[group];
+    lattice *node;
+    {
+        std::lock_guard<std::mutex> grd(pool.mtx);
+        if (pool.free == nullptr && !grow_pool(group))
+        {
+            return nullptr;
+        }
+        node = pool.free;
+        pool.free = pool.free->next;
+    }
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->keyed = 0;
+    node->span = 0xFF;
+    node->task = std::move(obj);
+    return node;
+}
+
+bool Scheduler::grow_pool(uint32_t group)
+{
+    auto bytes = SLAB * sizeof(lattice);
+#if defined(__linux__)
+    auto mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+    {
+        return false;
+    }
+#if defined(SCHD_HAVE_NUMA)
+    // bound before the constructors below touch the pages for the first time
+    if (topology[group].node >= 0)
+    {
+        numa_tonode_memory(mem, bytes, topology[group].node);
+    }
+#endif
+#else
+    auto mem = ::operator new(bytes, std::nothrow);
+    if (mem == nullptr)
+    {
+        return false;
+    }
+#endif
+    auto &pool = pools[group];
+    pool.slabs.push_back(mem);
+    auto nodes = static_cast<lattice *>(mem);
+    for (size_t i = 0; i < SLAB; i++)
+    {
+        auto node = ::new (&nodes[i]) lattice;
+        node->numa = static_cast<uint16_t>(group);
+        node->next = pool.free;
+        pool.free = node;
+    }
+    return true;
+}
+
+void Scheduler::release_pooled(lattice *first)
+{
+    while (first != nullptr)
+    {
+        // a chain claimed from one due list lives in one pool, so this is
+        // normally a single lock
+        auto &pool = pools[first->numa];
+        std::lock_guard<std::mutex> grd(pool.mtx);
+        while (first != nullptr && &pools[first->numa] == &pool)
+        {
+            auto next = first->next;
+            first->next = pool.free;
+            pool.free = first;
+            first = next;
+        }
+    }
+}
+
+NumaStats Scheduler::numa_stats()
+{
+    NumaStats stats{};
+    stats.nodes = static_cast<uint32_t>(topology.size());
+    for (size_t i = 0; i < topology.size(); i++)
+    {
+        stats.local_runs += workers->lanes[i].local_runs.load(std::memory_order_relaxed);
+        stats.remote_runs += workers->lanes[i].remote_runs.load(std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> grd(tw_mtx);
+        stats.local_moves = local_moves;
+        stats.remote_moves = remote_moves;
+    }
+    auto runs = stats.local_runs + stats.remote_runs;
+    auto moves = stats.local_moves + stats.remote_moves;
+    stats.remote_run_ratio = runs == 0 ? 0.0 : static_cast<double>(stats.remote_runs) / runs;
+    stats.remote_move_ratio = moves == 0 ? 0.0 : static_cast<double>(stats.remote_moves) / moves;
+    return stats;
+}
+
+uint16_t Scheduler::wheel_level(uint32_t ticks) const
+{
+    if (ticks <= fst_mask)
+    {
+        return 0;
+    }
+    uint16_t level = 1;
+    while (level < tw_nth.size() && ticks >= (1ull << (fst_bits + level * nth_bits)))
+    {
+        level++;
+    }
+    return level;
+}
+
+Scheduler::lattice *Scheduler::calculate_lattice(uint32_t ticks, uint32_t current_ticks, const lattice *node)
+{
+    auto expired_tick = current_ticks + ticks;
+    lattice *head{};
+    if (ticks <= fst_mask)
+    {
+        auto list = node->task.subtick != 0 ? static_cast<uint32_t>(topology.size()) : node->numa;
+        head = tw_1st[fst_slot(FST_IDX(expired_tick), list)];
+    }
+    else
+    {
+        for (size_t i = 0; i < tw_nth.size(); i++)
+        {
+            uint64_t sz = 1ull << (fst_bits + (i + 1) * nth_bits);
+            if (ticks < sz)
+            {
+                head = tw_nth[i][NTH_IDX(expired_tick, i)];
+                break;
+            }
+        }
+    }
+    return head;
+}
+
+void Scheduler::move_lattice_cascade(lattice *head, uint32_t current_ticks)
+{
+    while (head != head->next)
+    {
+        lattice *temp = head->next;
+        temp->next->prev = temp->prev;
+        temp->prev->next = temp->next;
+        move_node(temp, calculate_lattice(temp->task.expired - current_ticks, current_ticks, temp), current_ticks);
+    }
+}
+
+void Scheduler::move_node(lattice *node, lattice *pos, uint32_t current_ticks)
+{
+    samples.moved++;
+    tick_moves++;
+    if (pools)
+    {
+        (node->numa == tick_group ? local_moves : remote_moves)++;
+    }
+    SCHD_TRACE(CASCADE, node->task.trace_id, current_ticks, wheel_level(node->task.expired - current_ticks));
+    node->prev = pos->prev;
+    node->next = pos;
+    node->prev->next = node;
+    pos->prev = node;
+}
+
+Scheduler::lattice *Scheduler::next_cascade(size_t level, uint32_t current_ticks) const
+{
+    auto shift = fst_bits + static_cast<uint32_t>(level) * nth_bits;
+    auto wrap = ((current_ticks >> shift) + 1) << shift;
+    return tw_nth[level][NTH_IDX(wrap, level)];
+}
+
+Scheduler::lattice *Scheduler::refine_lattice(const lattice *node, size_t level, uint32_t current_ticks)
+{
+    // a slot of the level below already passed in its current lap next comes
+    // up in the lap starting at the wrap, so it takes the node right away,
+    // the others only once they have been passed
+    for (;;)
+    {
+        if (level == 0)
+        {
+            auto index = FST_IDX(node->task.expired);
+            auto list = node->task.subtick != 0 ? static_cast<uint32_t>(topology.size()) : node->numa;
+            return (index <= FST_IDX(current_ticks) ? tw_1st : stage_1st)[fst_slot(index, list)];
+        }
+        auto index = NTH_IDX(node->task.expired, level - 1);
+        auto passed = NTH_IDX(current_ticks, level - 1);
+        if (index > passed)
+        {
+            return stage_nth[level - 1][index];
+        }
+        // unless the level below wraps along with this one, which makes its
+        // slot 0 the next it cascades
+        if (index != 0 || passed != nth_mask)
+        {
+            return tw_nth[level - 1][index];
+        }
+        level--;
+    }
+}
+
+void Scheduler::cascade_ahead(uint32_t current_ticks)
+{
+    // lowest level first, its wrap comes soonest
+    for (size_t i = 0; i < tw_nth.size() && tick_moves < rt_config.max_cascade; i++)
+    {
+        auto head = next_cascade(i, current_ticks);
+        while (tick_moves < rt_config.max_cascade && head != head->next)
+        {
+            auto temp = head->next;
+            temp->next->prev = temp->prev;
+            temp->prev->next = temp->next;
+            move_node(temp, refine_lattice(temp, i, current_ticks), current_ticks);
+        }
+    }
+}
+
+bool Scheduler::insert_lattice(uint32_t ticks, lattice *node, char isRelative)
+{
+    if (node == nullptr)
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    auto current_ticks = currtick.load(std::memory_order_acquire);
+    if (isRelative == 'a' && ticks < current_ticks)
+    {
+        if (node->task.async)
+        {
+            node->task.async->abandon();
+        }
+        free_lattice(node);
+        return false;
+    }
+    if (node->task.owner_gen != 0 && !owner_current(node->task))
+    {
+        // a periodic task whose owner was cancelled while it ran
+        if (node->task.async)
+        {
+            node->task.async->abandon();
+        }
+        free_lattice(node);
+        return false;
+    }
+    uint32_t relative_ticks;
+    switch (isRelative)
+    {
+    case 'r':
+        relative_ticks = ticks;
+        break;
+    case 'a':
+        relative_ticks = ticks - current_ticks;
+        break;
+    case 'c':
+        relative_ticks = (currtick / ticks + 1) * ticks - currtick + 1;
+        break;
+    case 'n':
+        // not before an absolute tick, due on the next tick if already passed
+        relative_ticks = static_cast<int32_t>(ticks - current_ticks) > 0 ? ticks - current_ticks : 0;
+        break;
+    default:
+        free_lattice(node);
+        return false;
+    }
+    link_lattice(node, relative_ticks, current_ticks);
+    sample_arm(node, relative_ticks);
+    if (node->task.owner != 0)
+    {
+        link_owner(node);
+    }
+    return true;
+}
+
+void Scheduler::link_lattice(lattice *node, uint32_t relative_ticks, uint32_t current_ticks)
+{
+    node->task.expired = current_ticks + relative_ticks;
+    auto head = calculate_lattice(relative_ticks, current_ticks, node);
+    if (!stage_nth.empty())
+    {
+        // a slot being refined ahead takes nothing new, so it only shrinks
+        // until its wrap
+        auto level = wheel_level(relative_ticks);
+        if (level != 0 && head == next_cascade(level - 1, current_ticks - 1))
+        {
+            head = refine_lattice(node, level - 1, current_ticks - 1);
+        }
+    }
+    SCHD_TRACE_ID(node->task);
+    SCHD_TRACE(ARM, node->task.trace_id, current_ticks, wheel_level(relative_ticks));
+    node->prev = head->prev;
+    node->next = head;
+    node->prev->next = node;
+    head->prev = node;
+    if (timer_fd >= 0 && (!armed || static_cast<int32_t>(node->task.expired - armed_tick) < 0))
+    {
+        rearm_handle(node->task.expired);
+    }
+}
+
+bool Scheduler::dispatch(TaskObj &&obj)
+{
+    SCHD_TRACE_ID(obj);
+    if (!workers->submit(std::move(obj)))
+    {
+        // obj is left untouched when no node can be had either
+        return insert_lattice(0, alloc_lattice(std::move(obj)));
+    }
+    // a moved-from TaskObj keeps its scalar fields
+    SCHD_TRACE(DISPATCH, obj.trace_id, now(), 0);
+    return true;
+}
+
+bool Scheduler::arm_keyed(uint64_t key, uint32_t ticks, char mode, uint32_t site, std::function<void()> &&func)
+{
+    if (key == 0)
+    {
+        return false;
+    }
+    // a throttle window must span at least one tick so go() never re-arms into the slot it walks
+    auto window = mode == 't' && ticks == 0 ? 1 : ticks;
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    auto current_ticks = currtick.load(std::memory_order_acquire);
+    auto slot = keyed.insert(key);
+    if (slot->node != nullptr)
+    {
+        // later events only swap the payload, a debounce also pushes its expiry back
+        auto node = slot->node;
+        node->task.func = std::move(func);
+        node->task.site = site;
+        if (mode == 'd')
+        {
+            node->next->prev = node->prev;
+            node->prev->next = node->next;
+            sample_cancel(node);
+            link_lattice(node, ticks, current_ticks);
+            sample_arm(node, ticks);
+        }
+        slot->window = window;
+        return true;
+    }
+    auto node = alloc_lattice({0, 0, 0xFFFFFFFF, 1, std::move(func)});
+    if (node == nullptr)
+    {
+        return false;
+    }
+    node->task.site = site;
+    node->keyed = key;
+    slot->node = node;
+    slot->mode = mode;
+    slot->window = window;
+    link_lattice(node, mode == 't' ? 0 : ticks, current_ticks);
+    sample_arm(node, mode == 't' ? 0 : ticks);
+    return true;
+}
+
+void Scheduler::release_keyed(lattice *node, uint32_t current_ticks, bool fired)
+{
+    auto slot = keyed.find(node->keyed);
+    if (slot->mode == 't' && fired)
+    {
+        // keep the node armed to the end of the window for trailing events
+        link_lattice(node, slot->window - 1, current_ticks + 1);
+        return;
+    }
+    slot->node = nullptr;
+    free_lattice(node);
+}
+
+bool Scheduler::cancel_keyed(uint64_t key)
+{
+    lattice *node;
+    {
+        std::lock_guard<std::mutex> grd(tw_mtx);
+        auto slot = keyed.find(key);
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        node = slot->node;
+        slot->node = nullptr;
+        node->next->prev = node->prev;
+        node->prev->next = node->next;
+        sample_cancel(node);
+        if (armed && node->task.expired == armed_tick)
+        {
+            rearm_next();
+        }
+    }
+    free_lattice(node);
+    return record('c', key, 0);
+}
+
+void Scheduler::set_recorder(recorder_t fn)
+{
+    std::lock_guard<std::mutex> grd(record_mtx);
+    recorder = std::move(fn);
+    recording.store(static_cast<bool>(recorder), std::memory_order_release);
+}
+
+void Scheduler::record_event(char op, uint64_t key, uint32_t ticks)
+{
+    // the tick is read under the lock, so events reach the recorder in tick order
+    std::lock_guard<std::mutex> grd(record_mtx);
+    if (recorder)
+    {
+        recorder(now(), op, key, ticks);
+    }
+}
+
+void Scheduler::link_owner(lattice *node)
+{
+    auto slot = owners.insert(node->task.owner);
+    if (slot->gen == 0)
+    {
+        slot->gen = 1;
+    }
+    // a re-armed periodic task keeps the generation it was first armed under
+    if (node->task.owner_gen == 0)
+    {
+        node->task.owner_gen = slot->gen;
+    }
+    if (slot->first == nullptr)
+    {
+        node->owner_prev = node;
+        node->owner_next = node;
+        slot->first = node;
+        return;
+    }
+    node->owner_prev = slot->first->owner_prev;
+    node->owner_next = slot->first;
+    node->owner_prev->owner_next = node;
+    slot->first->owner_prev = node;
+}
+
+void Scheduler::unlink_owner(lattice *node)
+{
+    if (node->owner_next == nullptr)
+    {
+        return;
+    }
+    auto slot = owners.find(node->task.owner);
+    if (node->owner_next == node)
+    {
+        slot->first = nullptr;
+    }
+    else
+    {
+        node->owner_next->owner_prev = node->owner_prev;
+        node->owner_prev->owner_next = node->owner_next;
+        if (slot->first == node)
+        {
+            slot->first = node->owner_next;
+        }
+    }
+    node->owner_prev = nullptr;
+    node->owner_next = nullptr;
+    slot->running++;
+}
+
+bool Scheduler::owner_current(const TaskObj &task)
+{
+    auto slot = owners.find(task.owner);
+    return slot != nullptr && slot->gen == task.owner_gen;
+}
+
+bool Scheduler::owner_cancelled(const TaskObj &task)
+{
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    return !owner_current(task);
+}
+
+void Scheduler::release_owner(uint64_t owner)
+{
+    // the last task out with nothing pending turns the slot into a tombstone
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    owners.find(owner)->running--;
+}
+
+size_t Scheduler::cancel_all(OwnerID owner)
+{
+    lattice *first;
+    {
+        std::lock_guard<std::mutex> grd(tw_mtx);
+        auto slot = owners.find(owner.key);
+        if (slot == nullptr)
+        {
+            return 0;
+        }
+        // voids the tasks of owner already out in the pool
+        if (++slot->gen == 0)
+        {
+            slot->gen = 1;
+        }
+        first = slot->first;
+        slot->first = nullptr;
+        bool earliest = false;
+        auto temp = first;
+        while (temp != nullptr)
+        {
+            temp->next->prev = temp->prev;
+            temp->prev->next = temp->next;
+            sample_cancel(temp);
+            earliest |= armed && temp->task.expired == armed_tick;
+            temp = temp->owner_next != first ? temp->owner_next : nullptr;
+        }
+        if (earliest)
+        {
+            rearm_next();
+        }
+    }
+    size_t count = 0;
+    if (first != nullptr)
+    {
+        first->owner_prev->owner_next = nullptr;
+    }
+    while (first != nullptr)
+    {
+        auto temp = first;
+        first = temp->owner_next;
+        if (temp->task.async)
+        {
+            temp->task.async->abandon();
+        }
+        free_lattice(temp);
+        count++;
+    }
+    record('o', owner.key, 0);
+    return count;
+}
+
+uint32_t Scheduler::next_expiry(uint32_t current_ticks) const
+{
+    auto nearest = std::numeric_limits<uint32_t>::max();
+    auto scan = [&nearest, current_ticks](const lattice *head)
+    {
+        for (auto temp = head->next; temp != head; temp = temp->next)
+        {
+            nearest = std::min(nearest, temp->task.expired - current_ticks);
+        }
+    };
+    // first level slots hold exactly one tick each within the next lap
+    for (uint32_t i = 0; i <= fst_mask; i++)
+    {
+        if (!slot_empty(FST_IDX(current_ticks + i)))
+        {
+            nearest = i;
+            break;
+        }
+    }
+    // staged nodes belong to the next lap of their level, in slot order
+    for (uint32_t i = 0; !stage_1st.empty() && i <= fst_mask; i++)
+    {
+        auto index = FST_IDX(current_ticks + i);
+        if (!stage_empty(index))
+        {
+            for (uint32_t j = 0; j <= topology.size(); j++)
+            {
+                scan(stage_1st[fst_slot(index, j)]);
+            }
+            break;
+        }
+    }
+    for (size_t j = 0; j < stage_nth.size(); j++)
+    {
+        auto base = NTH_IDX(current_ticks, j);
+        for (uint32_t i = 0; i <= nth_mask; i++)
+        {
+            auto head = stage_nth[j][(base + i) & nth_mask];
+            if (head != head->next)
+            {
+                scan(head);
+                break;
+            }
+        }
+    }
+    // upper levels are ordered by slot, except the current slot which may also
+    // hold timers wrapped around a full level period
+    for (size_t j = 0; j < tw_nth.size(); j++)
+    {
+        auto base = NTH_IDX(current_ticks, j);
+        for (uint32_t i = 0; i <= nth_mask; i++)
+        {
+            auto head = tw_nth[j][(base + i) & nth_mask];
+            if (head != head->next)
+            {
+                scan(head);
+                if (i != 0)
+                {
+                    break;
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+#if defined(__linux__)
+void Scheduler::rearm_handle(uint32_t expired_tick)
+{
+    auto due = epoch_ns + static_cast<int64_t>(expired_tick - epoch_tick) * tick_ns.count();
+    // a zero it_value would disarm the timer, so an overdue tick fires at once
+    due = std::max<int64_t>(due, 1);
+    itimerspec its{};
+    its.it_value.tv_sec = due / 1000000000;
+    its.it_value.tv_nsec = due % 1000000000;
+    timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, nullptr);
+    armed_tick = expired_tick;
+    armed = true;
+}
+
+int Scheduler::native_handle()
+{
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    if (virtual_time)
+    {
+        // virtual time never becomes due on its own
+        return -1;
+    }
+    if (timer_fd < 0)
+    {
+        timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timer_fd < 0)
+        {
+            return timer_fd;
+        }
+        epoch_ns = monotonic_ns();
+        epoch_tick = currtick.load(std::memory_order_acquire);
+        auto relative_ticks = next_expiry(epoch_tick);
+        if (relative_ticks != std::numeric_limits<uint32_t>::max())
+        {
+            rearm_handle(epoch_tick + relative_ticks);
+        }
+    }
+    return timer_fd;
+}
+
+void Scheduler::process_ready()
+{
+    if (timer_fd < 0)
+    {
+        return;
+    }
+    uint64_t expirations;
+    while (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+    {
+    }
+    auto elapsed_ticks = static_cast<uint32_t>((monotonic_ns() - epoch_ns) / tick_ns.count());
+    auto behind = static_cast<int32_t>(epoch_tick + elapsed_ticks - now());
+    if (behind >= 0)
+    {
+        // idle ticks are skipped rather than stepped one go() at a time
+        advance(static_cast<uint32_t>(behind) + 1);
+    }
+    std::lock_guard<std::mutex> grd(tw_mtx);
+    rearm_next();
+}
+
+void Scheduler::rearm_next()
+{
+    auto current_ticks = currtick.load(std::memory_order_acquire);
+    auto relative_ticks = next_expiry(current_ticks);
+    if (relative_ticks == std::numeric_limits<uint32_t>::max())
+    {
+        itimerspec its{};
+        timerfd_settime(timer_fd, 0, &its, nullptr);
+        armed = false;
+        return;
+    }
+    rearm_handle(current_ticks + relative_ticks);
+}
+#else
+void Scheduler::rearm_handle(uint32_t)
+{
+}
+
+void Scheduler::rearm_next()
+{
+}
+
+int Scheduler::native_handle()
+{
+    return -1;
+}
+
+void Scheduler::process_ready()
+{
+}
+#endif
+
+Worker::Worker(Scheduler &_tw, bool threaded)
+    : queue(std::make_unique<TaskObj[]>(MAX_SIZE)),
+      front(1), rear(0), stop(false), tw(_tw), inline_mode(!threaded)
+{
+    auto groups = tw.topology.size();
+    if (tw.group_threads != 0)
+    {
+        per_group = tw.group_threads;
+    }
+    lanes = std::make_unique<lane[]>(groups);
+    costs = std::vector<std::atomic<CostTable *>>(groups * per_group + 1);
+    if (inline_mode)
+    {
+        inline_chunk = std::make_unique<TaskObj[]>(CHUNK);
+    }
+    for (size_t i = 0; threaded && i < groups * per_group; i++)
+    {
+        thd.emplace_back(&Worker::do_work, this, i);
+    }
+}
+
+Worker::~Worker()
+{
+    {
+        std::lock_guard<std::mutex> grd(mtx);
+        stop = true;
+    }
+    for (size_t i = 0; i < tw.topology.size(); i++)
+    {
+        lanes[i].signal.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake_all(lanes[i].signal);
+    }
+    precise_cond.notify_all();
+    if (precise_thd.joinable())
+    {
+        precise_thd.join();
+    }
+    for (auto &ele : thd)
+    {
+        ele.join();
+    }
+    for (auto &ele : costs)
+    {
+        delete ele.load();
+    }
+    for (auto &ele : ready)
+    {
+        if (ele.async)
+        {
+            ele.async->abandon();
+        }
+    }
+}
+
+void Worker::submit_precise(Scheduler::lattice *first, Scheduler::lattice *last)
+{
+    if (inline_mode)
+    {
+        // no sub-tick deadlines in virtual time, only their order is kept
+        while (first != nullptr)
+        {
+            auto next = first->next;
+            ready.push_back(std::move(first->task));
+            tw.free_lattice(first);
+            first = next;
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> grd(mtx);
+        if (!precise_thd.joinable())
+        {
+            precise_thd = std::thread(&Worker::do_precise, this);
+        }
+        if (precise_last == nullptr)
+        {
+            precise_first = first;
+            precise_last = last;
+        }
+        else if (precise_last->deadline <= first->deadline)
+        {
+            precise_last->next = first;
+            precise_last = last;
+        }
+        else
+        {
+            // a tick's sub-tick nodes may arrive over several claims
+            precise_last->next = first;
+            precise_first = Scheduler::sort_deadline(precise_first);
+            for (precise_last = precise_first; precise_last->next != nullptr; precise_last = precise_last->next)
+            {
+            }
+        }
+    }
+    precise_cond.notify_one();
+}
+
+void Worker::do_precise()
+{
+    std::unique_lock<std::mutex> lck(mtx);
+    for (;;)
+    {
+        precise_cond.wait(lck, [this]()
+                          { return stop || precise_first != nullptr; });
+        if (precise_first == nullptr)
+        {
+            return;
+        }
+        auto node = precise_first;
+        // sleep most of the way, woken early if an earlier deadline is merged in
+        auto wake = node->deadline - SPIN_NS;
+        if (wake > monotonic_ns())
+        {
+            precise_cond.wait_until(lck, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(wake)), [this, node]()
+                                    { return precise_first != node; });
+            continue;
+        }
+        precise_first = node->next;
+        if (precise_first == nullptr)
+        {
+            precise_last = nullptr;
+        }
+        lck.unlock();
+        // then spin the last stretch
+        while (node->deadline - monotonic_ns() > 0)
+        {
+            cpu_relax();
+        }
+        auto task = std::move(node->task);
+        tw.free_lattice(node);
+        // strand tasks still go through the pool to keep their ordering; with
+        // the ring full they queue behind a busy strand or run here instead,
+        // as release_strand does
+        auto strand = task.strand;
+        if (strand == 0 || !submit(std::move(task)))
+        {
+            bool owned = true;
+            if (strand != 0)
+            {
+                lck.lock();
+                owned = claim_strand(task);
+                lck.unlock();
+            }
+            if (owned)
+            {
+                execute(task, costs.size() - 1);
+            }
+            while (owned && strand != 0 && release_strand(strand, task))
+            {
+                execute(task, costs.size() - 1);
+            }
+        }
+        lck.lock();
+    }
+}
+
+bool Worker::submit(TaskObj &&obj)
+{
+    if (inline_mode)
+    {
+        // one thread runs everything in order, which already satisfies strands
+        ready.push_back(std::move(obj));
+        return true;
+    }
+    if (obj.home >= tw.topology.size())
+    {
+        obj.home = tw.topology.size() > 1 ? tw.caller_group() : 0;
+    }
+    // any node's threads may take it from the shared queue, its own are woken first
+    auto group = obj.home;
+    {
+        std::lock_guard<std::mutex> grd(mtx);
+        if (stop)
+        {
+            return false;
+        }
+        if (obj.strand != 0)
+        {
+            if (auto waiting = strand_table.find(obj.strand))
+            {
+                push_strand(waiting, std::move(obj));
+                return true;
+            }
+            auto key = obj.strand;
+            if (!enqueue(std::move(obj)))
+            {
+                return false;
+            }
+            open_strand(key);
+        }
+        else if (!enqueue(std::move(obj)))
+        {
+            return false;
+        }
+    }
+    notify(1, group);
+    return true;
+}
+
+void Worker::notify(uint32_t count, uint32_t group)
+{
+    auto &own = lanes[group];
+    own.signal.fetch_add(1, std::memory_order_seq_cst);
+    if (own.sleepers.load(std::memory_order_seq_cst) != 0)
+    {
+        futex_wake(own.signal, static_cast<int>(std::min<size_t>(count, per_group)));
+    }
+}
+
+void Worker::await(uint32_t group, uint32_t key)
+{
+    auto &signal = lanes[group].signal;
+    auto &sleepers = lanes[group].sleepers;
+    auto mode = policy.load(std::memory_order_relaxed);
+    auto spin = mode == WakePolicy::SPIN_PARK ? spin_polls.load(std::memory_order_relaxed) : 0;
+    auto yield = mode == WakePolicy::SPIN_PARK ? yield_polls.load(std::memory_order_relaxed) : 0;
+    uint32_t polls = 0;
+    while (signal.load(std::memory_order_acquire) == key)
+    {
+        if (mode == WakePolicy::BUSY_POLL || polls < spin)
+        {
+            cpu_relax();
+        }
+        else if (polls < spin + yield)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            // announce ourselves before the final check, notify() reads
+            // sleepers after bumping signal so one of the two always sees the other
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (signal.load(std::memory_order_seq_cst) == key)
+            {
+                futex_wait(signal, key);
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        polls++;
+    }
+}
+
+void Worker::enter_group(uint32_t group)
+{
+    pool_owner = this;
+    pool_group = group;
+#if defined(__linux__)
+    auto &cpus = tw.topology[group].cpus;
+    if (tw.pools && !cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (auto cpu : cpus)
+        {
+            CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+}
+
+void Worker::do_work(size_t slot)
+{
+    auto group = static_cast<uint32_t>(slot / per_group);
+    enter_group(group);
+    auto &signal = lanes[group].signal;
+    TaskObj chunk[CHUNK];
+    for (;;)
+    {
+        // read before looking for work, so work queued after the look
+        // always leaves signal changed for await()
+        auto key = signal.load(std::memory_order_acquire);
+        auto claimed = tw.claim_due(chunk, CHUNK, group);
+        if (claimed != 0)
+        {
+            run_chunk(chunk, claimed, slot);
+            continue;
+        }
+        TaskObj task;
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            if (length() == 0)
+            {
+                if (stop)
+                {
+                    return;
+                }
+                lck.unlock();
+                await(group, key);
+                continue;
+            }
+            task = std::move(queue[front]);
+            front = (front + 1) % MAX_SIZE;
+        }
+        auto strand = task.strand;
+        execute(task, slot);
+        while (strand != 0 && release_strand(strand, task))
+        {
+            execute(task, slot);
+        }
+    }
+}
+
+void Worker::run_chunk(TaskObj *chunk, size_t count, size_t slot)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        // claim_due already made this thread the owner of any strand here
+        auto &task = chunk[i];
+        auto strand = task.strand;
+        execute(task, slot);
+        while (strand != 0 && release_strand(strand, task))
+        {
+            execute(task, slot);
+        }
+        // drop captured state now rather than on the next claim
+        task = {};
+    }
+}
+
+bool Worker::claim_strand(TaskObj &task)
+{
+    if (auto waiting = strand_table.find(task.strand))
+    {
+        push_strand(waiting, std::move(task));
+        return false;
+    }
+    open_strand(task.strand);
+    return true;
+}
+
+void Worker::reserve_strands(size_t count)
+{
+    std::lock_guard<std::mutex> grd(mtx);
+    strand_table.reserve(count);
+    // resizing rather than reserving faults every page in up front
+    auto first = strand_cells.size();
+    strand_cells.resize(first + count);
+    for (auto i = first + count; i-- > first;)
+    {
+        strand_cells[i].next = strand_free;
+        strand_free = static_cast<uint32_t>(i);
+    }
+}
+
+void Worker::open_strand(uint64_t key)
+{
+    strand_table.insert(key)->active = true;
+}
+
+void Worker::close_strand(strand_slot *slot)
+{
+    // nothing waits any more, the slot becomes a tombstone
+    slot->active = false;
+}
+
+void Worker::push_strand(strand_slot *slot, TaskObj &&task)
+{
+    if (strand_free == NO_CELL)
+    {
+        // the slot lives in strand_slots, growing the cells leaves it alone
+        strand_free = static_cast<uint32_t>(strand_cells.size());
+        strand_cells.emplace_back();
+    }
+    auto cell = strand_free;
+    strand_free = strand_cells[cell].next;
+    strand_cells[cell].task = std::move(task);
+    strand_cells[cell].next = NO_CELL;
+    if (slot->tail == NO_CELL)
+    {
+        slot->head = cell;
+    }
+    else
+    {
+        strand_cells[slot->tail].next = cell;
+    }
+    slot->tail = cell;
+}
+
+bool Worker::pop_strand(strand_slot *slot, TaskObj &task)
+{
+    auto cell = slot->head;
+    if (cell == NO_CELL)
+    {
+        return false;
+    }
+    task = std::move(strand_cells[cell].task);
+    // drop captured state now rather than when the cell is reused
+    strand_cells[cell].task = {};
+    slot->head = strand_cells[cell].next;
+    if (slot->head == NO_CELL)
+    {
+        slot->tail = NO_CELL;
+    }
+    strand_cells[cell].next = strand_free;
+    strand_free = cell;
+    return true;
+}
+
+void Worker::run_inline()
+{
+    for (;;)
+    {
+        auto claimed = tw.claim_due(inline_chunk.get(), CHUNK);
+        for (size_t i = 0; i < claimed; i++)
+        {
+            execute(inline_chunk[i], 0);
+            inline_chunk[i] = {};
+        }
+        if (claimed != 0)
+        {
+            continue;
+        }
+        if (ready.empty())
+        {
+            return;
+        }
+        auto task = std::move(ready.front());
+        ready.pop_front();
+        execute(task, 0);
+    }
+}
+
+static int64_t thread_cpu_ns()
+{
+#if defined(__linux__)
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return monotonic_ns();
+#endif
+}
+
+void Worker::execute(TaskObj &task, size_t slot)
+{
+    auto table = profiling.load(std::memory_order_relaxed) ? costs[slot].load(std::memory_order_acquire) : nullptr;
+    auto cpu_begin = table != nullptr ? thread_cpu_ns() : 0;
+    if (tw.pools)
+    {
+        // the precise thread is not pinned and goes by the cpu it runs on
+        auto group = slot < thd.size() ? static_cast<uint32_t>(slot / per_group) : tw.caller_group();
+        auto &own = lanes[group];
+        (task.home == group ? own.local_runs : own.remote_runs).fetch_add(1, std::memory_order_relaxed);
+    }
+    if (task.owner_gen != 0 && tw.owner_cancelled(task))
+    {
+        // cancel_all ran while it waited in a ring or a strand backlog
+        if (task.async)
+        {
+            task.async->abandon();
+        }
+        tw.release_owner(task.owner);
+        return;
+    }
+    task.started = tw.now();
+    SCHD_TRACE(START, task.trace_id, task.started, static_cast<uint16_t>(slot));
+    try
+    {
+        if (task.async)
+        {
+            task.async->run();
+        }
+        else
+        {
+            task.func();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        printf("error: %s\n", e.what());
+        throw e;
+    }
+    if (table != nullptr)
+    {
+        auto spent = thread_cpu_ns() - cpu_begin;
+        auto budget = budget_ns.load(std::memory_order_relaxed);
+        table->record(task.site, spent, budget != 0 && spent > budget);
+    }
+    SCHD_TRACE(END, task.trace_id, tw.now(), static_cast<uint16_t>(slot));
+    auto exceed_ticks = tw.now() - task.started;
+    auto penalty_ticks = task.duration != 0 ? task.duration - 1 : task.duration;
+    if (task.duration != 0 && exceed_ticks > task.duration)
+    {
+        penalty_ticks += exceed_ticks;
+        if (task.hand)
+        {
+            task.hand(exceed_ticks, task.counters);
+        }
+    }
+    auto owner = task.owner_gen != 0 ? task.owner : 0;
+    if (--task.counters != 0)
+    {
+        // insert_lattice drops it if the owner was cancelled while it ran
+        tw.insert_lattice(penalty_ticks, tw.alloc_lattice(std::move(task)));
+    }
+    if (owner != 0)
+    {
+        tw.release_owner(owner);
+    }
+}
+
+bool Worker::release_strand(uint64_t strand, TaskObj &next)
+{
+    {
+        std::lock_guard<std::mutex> grd(mtx);
+        auto waiting = strand_table.find(strand);
+        if (!pop_strand(waiting, next))
+        {
+            close_strand(waiting);
+            return false;
+        }
+        // hand the strand back to the pool to stay fair to other keys,
+        // keep running it here only when the ring has no room left
+        if (stop || !enqueue(std::move(next)))
+        {
+            return true;
+        }
+    }
+    notify(1);
+    return false;
+}
@@ -8,6 +8,12 @@
 #include <mutex>
 #include <vector>
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include "completion.h"
+#include "keytable.h"
+#include "taskcost.h"
+#include "tasktrace.h"
 // only for debug
 #include <iostream>
 #include <iomanip>
@@ -26,6 +32,47 @@ struct RelativeTimeTick
     uint32_t tick;
 };
 
+struct StrandID
+{
+    constexpr StrandID(uint64_t k) : key(k){};
+    uint64_t key;
+};
+
+// offset in nanoseconds into the due tick, honoured by the precise-timing thread
+struct SubTick
+{
+    constexpr SubTick(uint32_t ns) : offset(ns){};
+    uint32_t offset;
+};
+
+struct OwnerID
+{
+    constexpr OwnerID(uint64_t k) : key(k){};
+    uint64_t key;
+};
+
+// rate-limit class set up with set_rate_limit, 0 is never limited
+struct RateClass
+{
+    constexpr RateClass(uint32_t i) : id(i){};
+    uint32_t id;
+};
+
+// NUMA node a task runs on and keeps its timer node on, by default the node
+// of the thread arming it
+struct NumaNode
+{
+    constexpr NumaNode(uint32_t i) : id(i){};
+    uint32_t id;
+};
+
+struct RateStats
+{
+    uint64_t released;
+    // times a task found the bucket empty and was pushed to a later tick
+    uint64_t deferred;
+};
+
 constexpr AbsoluteTimeTick operator"" _ABST(unsigned long long t)
 {
     return {static_cast<uint32_t>(t)};
@@ -44,28 +91,141 @@ struct TaskObj
     uint32_t counters{};
     std::function<void()> func{};
     std::function<void(uint32_t exceed_tick, uint32_t &counters)> hand;
+    // tasks sharing a non-zero strand run in FIFO order, never concurrently
+    uint64_t strand{};
+    // non-zero owners can drop all of their pending timers with cancel_all
+    uint64_t owner{};
+    // owner generation the task was first armed under, 0 for none
+    uint32_t owner_gen{};
+    // nanoseconds into the due tick, 0 dispatches with the tick as usual
+    uint32_t subtick{};
+    // callable type id for cost accounting, filled in by set_task
+    uint32_t site{};
+    // token bucket the task draws from when released, 0 for none
+    uint32_t rate_class{};
+    // set instead of func for SCHD_ASYNC_TASK, owns its callable and result
+    CompletionBase *async{};
+    // lifecycle id for SCHD_ENABLE_TRACE builds, assigned when first armed
+    uint64_t trace_id{};
+    // NUMA node whose pool threads run the task, ~0u for the node of the arming thread
+    uint32_t home{~0u};
+};
+
+// how idle pool threads wait for work: PARK sleeps in the kernel right away,
+// SPIN_PARK polls and then yields before parking, BUSY_POLL never sleeps and
+// trades a whole core per thread for the lowest dispatch latency
+enum class WakePolicy
+{
+    PARK,
+    SPIN_PARK,
+    BUSY_POLL
+};
+
+struct WakeConfig
+{
+    WakePolicy policy{WakePolicy::PARK};
+    // empty polls spent in the spin and then the yield phase of SPIN_PARK
+    uint32_t spin{4000};
+    uint32_t yield{100};
+};
+
+// selects the virtual clock: nothing runs in the background, go() runs the
+// due tasks on the calling thread in wheel order and advance() or step() jump
+// over idle ticks, so a simulation is fast and fully reproducible
+struct VirtualClock
+{
+};
+
+// hard real-time profile: every timer node comes from a fixed, locked arena,
+// so neither go() nor a worker touches the allocator once it is warmed up
+struct RealtimeConfig
+{
+    // timers pending at once; inserts beyond it fail instead of allocating,
+    // as do callables too large for std::function to keep inline
+    size_t capacity{};
+    // due nodes a worker claims per hold of the wheel lock, bounding how long
+    // go() can wait for it; 0 uses Worker::CHUNK
+    uint32_t max_dispatch{};
+    // nodes go() moves down the wheel per tick, refining the slot each level
+    // cascades at its next wrap ahead of time; 0 moves a whole slot at its wrap
+    uint32_t max_cascade{};
+    bool lock_memory{true};
+    // SCHED_FIFO priority applied by enter_tick_thread(), 0 keeps the current policy
+    int tick_priority{};
+    // cpu the tick thread is pinned to by enter_tick_thread(), -1 keeps the affinity
+    int tick_cpu{-1};
+};
+
+// bit split of the wheel: 2^fst_bits slots of one tick each, then levels of
+// 2^nth_bits slots, a slot of each level spanning a full lap of the one below
+struct WheelLayout
+{
+    uint32_t fst_bits{8};
+    uint32_t nth_bits{6};
+    uint32_t levels{4};
+};
+
+// bucket b of armed and cancelled counts timers armed 2^(b-1) to 2^b - 1
+// ticks ahead, bucket 0 those due on the next tick
+struct WheelProfile
+{
+    uint64_t armed[33];
+    uint64_t cancelled[33];
+    uint64_t fired;
+    // nodes moved by cascading per fired timer, as observed
+    double observed_cost;
+    // the same as the histogram predicts for either layout
+    double current_cost;
+    double recommended_cost;
+    WheelLayout current;
+    WheelLayout recommended;
+};
+
+// NUMA placement: timer nodes come from slabs bound to the memory of their
+// home node, every node gets its own group of pool threads pinned to its
+// cpus, and go() hands a due task only to the group of the node it lives on
+struct NumaConfig
+{
+    // 0 takes the machine topology within the cpus this process may use, as
+    // narrowed by numactl; otherwise that many nodes are emulated by dealing
+    // out those cpus round robin
+    uint32_t nodes{};
+    // pool threads per node, 0 for the default pool size
+    uint32_t threads{};
+};
+
+struct NumaStats
+{
+    uint32_t nodes;
+    // tasks run by a thread of their home node, and by any other thread
+    uint64_t local_runs;
+    uint64_t remote_runs;
+    // timer nodes the tick thread cascaded, by whether they live on its node
+    uint64_t local_moves;
+    uint64_t remote_moves;
+    // share of runs, and of moves, that crossed nodes
+    double remote_run_ratio;
+    double remote_move_ratio;
 };
 
 class Worker;
+class TaskGraph;
 
 class Scheduler
 {
     friend class Worker;
-    constexpr static uint32_t TWR_BITS = 8;
-    constexpr static uint32_t TWN_BITS = 6;
-    constexpr static uint32_t TWR_SIZE = 1 << TWR_BITS;
-    constexpr static uint32_t TWN_SIZE = 1 << TWN_BITS;
-    constexpr static uint32_t TWR_MASK = TWR_SIZE - 1;
-    constexpr static uint32_t TWN_MASK = TWN_SIZE - 1;
+    friend class TaskGraph;
+    // log2 buckets of relative ticks sampled by the wheel profile
+    constexpr static size_t SPANS = 33;
 
-    constexpr static auto FST_IDX(uint32_t t)
+    uint32_t FST_IDX(uint32_t t) const
     {
-        return t & TWR_MASK;
+        return t & fst_mask;
     }
 
-    constexpr static auto NTH_IDX(uint32_t t, size_t n)
+    uint32_t NTH_IDX(uint32_t t, size_t n) const
     {
-        return (t >> (TWR_BITS + n * TWN_BITS)) & TWN_MASK;
+        return (t >> (fst_bits + n * nth_bits)) & nth_mask;
     }
 
     struct lattice
@@ -73,6 +233,17 @@ class Scheduler
         lattice *prev{};
         lattice *next{};
         TaskObj task{};
+        // ring of all pending nodes sharing task.owner, null while not in one
+        lattice *owner_prev{};
+        lattice *owner_next{};
+        // non-zero for the single node armed by debounce or throttle
+        uint64_t keyed{};
+        // monotonic ns a sub-tick task is released at
+        int64_t deadline{};
+        // span bucket it was armed with while the wheel profile runs, 0xFF if unsampled
+        uint8_t span{0xFF};
+        // NUMA node whose slab pool the node was carved from
+        uint16_t numa{};
 
         static void set_init(lattice *node)
         {
@@ -91,6 +262,22 @@ class Scheduler
             }
         }
 
+        // one lock for a next-linked chain of nodes whose tasks are already cleared
+        static void recycle(lattice *first, lattice *last)
+        {
+            for (auto temp = first; temp != last;)
+            {
+                auto next = temp->next;
+                temp->~lattice();
+                temp->next = next;
+                temp = next;
+            }
+            last->~lattice();
+            std::lock_guard<std::mutex> grd(mem_mtx);
+            last->next = freelist;
+            freelist = first;
+        }
+
         static void print_free_list()
         {
             // for debug
@@ -104,15 +291,28 @@ class Scheduler
             std::cout << "\n";
         }
 
+        // nodes come off the shared list up to BATCH per lock into a per
+        // thread cache, which goes back to the shared list at thread exit
         void *operator new(size_t)
         {
-            std::lock_guard<std::mutex> grd(mem_mtx);
-            if (freelist == nullptr)
+            auto &c = local();
+            if (c.head == nullptr)
             {
-                return ::new lattice;
+                std::lock_guard<std::mutex> grd(mem_mtx);
+                for (size_t i = 0; i < BATCH && freelist != nullptr; i++)
+                {
+                    auto temp = freelist;
+                    freelist = freelist->next;
+                    temp->next = c.head;
+                    c.head = temp;
+                }
+                if (c.head == nullptr)
+                {
+                    return ::new lattice;
+                }
             }
-            auto *temp = freelist;
-            freelist = freelist->next;
+            auto *temp = c.head;
+            c.head = c.head->next;
             return temp;
         }
 
@@ -124,93 +324,195 @@ class Scheduler
         }
 
     private:
+        static constexpr size_t BATCH = 64;
+
+        struct cache
+        {
+            lattice *head{};
+
+            ~cache()
+            {
+                if (head == nullptr)
+                {
+                    return;
+                }
+                auto last = head;
+                while (last->next != nullptr)
+                {
+                    last = last->next;
+                }
+                std::lock_guard<std::mutex> grd(mem_mtx);
+                last->next = freelist;
+                freelist = head;
+            }
+        };
+
+        static cache &local()
+        {
+            thread_local cache instance;
+            return instance;
+        }
+
         static lattice *freelist;
         static std::mutex mem_mtx;
     };
 
-    using tw_fst_t = lattice *[TWR_SIZE];
-    using tw_nth_t = lattice *[TWN_SIZE];
-
 public:
-    explicit Scheduler(uint32_t current_time = 0);
+    explicit Scheduler(uint32_t current_time = 0, std::chrono::nanoseconds resolution = std::chrono::milliseconds(1));
+    // with a real-time profile go() never allocates and hands the due slot to
+    // the pool with one O(1) splice; without max_cascade a tick that wraps a
+    // level moves every node of the cascaded slot at once, up to capacity of
+    // them. With it the slot is refined over the 2^fst_bits or more ticks
+    // before its wrap and takes no new timers meanwhile, so while at most
+    // max_cascade << fst_bits timers are pending no go() moves more than
+    // max_cascade nodes; beyond that a wrap moves whatever is left over
+    explicit Scheduler(const RealtimeConfig &config, uint32_t current_time = 0,
+                       std::chrono::nanoseconds resolution = std::chrono::milliseconds(1));
+    explicit Scheduler(VirtualClock, uint32_t current_time = 0,
+                       std::chrono::nanoseconds resolution = std::chrono::milliseconds(1));
+    explicit Scheduler(const NumaConfig &config, uint32_t current_time = 0,
+                       std::chrono::nanoseconds resolution = std::chrono::milliseconds(1));
     ~Scheduler();
 
     void go();
 
-    uint32_t now() const
+    bool simulated() const
     {
-        return currtick.load(std::memory_order_acquire);
+        return virtual_time;
     }
 
-    void set_task(RelativeTimeTick time, TaskObj obj)
-    {
-        insert_lattice(time.tick, new lattice{nullptr, nullptr, std::move(obj)});
-    }
+    // may be changed while running, parked threads pick it up on their next wait
+    void set_wake_policy(const WakeConfig &config);
+
+    // virtual clock only: processes the next ticks ticks, skipping idle ones,
+    // and returns how many go() actually had to run
+    uint32_t advance(uint32_t ticks);
 
-    void set_task(RelativeTimeTick time, TaskObj obj)
+    // virtual clock only: jumps to the next tick with anything to do and
+    // processes it, false once the wheel is empty
+    bool step();
+
+    // applies the SCHED_FIFO priority and cpu affinity of the real-time profile
+    // to the calling thread, meant to be called once from the thread driving go()
+    bool enter_tick_thread() const;
+
+    bool memory_locked() const
     {
-        insert_lattice(time.tick, new lattice{nullptr, nullptr, std::move(obj)}, 'a');
+        return locked;
     }
 
-    template <class Fn, class... Args>
-    void set_task(RelativeTimeTick time, Fn &&Fx, Args &&...Ax)
+    // most nodes a single go() has moved between wheel levels so far
+    uint32_t cascade_peak() const
     {
-        auto temp = new lattice{nullptr, nullptr, {0, 0, 0xFFFFFFFF, 1, std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}};
-        insert_lattice(time.tick, temp);
+        return peak_moves;
     }
 
-    template <class Fn, class... Args>
-    void set_task(AbsoluteTimeTick time, Fn &&Fx, Args &&...Ax)
+    // timerfd that turns readable when the next timer is due, for use in an
+    // external epoll loop together with process_ready() instead of a tick thread
+    int native_handle();
+
+    // catches up with every tick elapsed since native_handle(), skipping idle
+    // ones, and re-arms the fd
+    void process_ready();
+
+    uint32_t now() const
     {
-        auto temp = new lattice{nullptr, nullptr, {0, 0, 0xFFFFFFFF, 1, std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}};
-        insert_lattice(time.tick, temp, 'a');
+        return currtick.load(std::memory_order_acquire);
     }
 
+    // runs the latest fn once ticks have passed without another call for key
     template <class Fn, class... Args>
-    void set_task(RelativeTimeTick time, AbsoluteTimeTick period, uint32_t cycles, Fn &&Fx, Args &&...Ax)
+    bool debounce(uint64_t key, RelativeTimeTick ticks, Fn &&Fx, Args &&...Ax)
     {
-        auto temp = new lattice{nullptr, nullptr, {0, 0, period.tick, cycles, std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}};
-        insert_lattice(time.tick, temp);
+        if (oversized<Fn, Args...>())
+        {
+            return false;
+        }
+        auto ok = arm_keyed(key, ticks.tick, 'd', TaskSite::of<std::decay_t<Fn>>(), bind_task(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+        return ok && record('d', key, ticks.tick);
     }
 
+    // runs fn on the next tick, then at most once per ticks with the latest
+    // fn received in between
     template <class Fn, class... Args>
-    void set_task(AbsoluteTimeTick time, AbsoluteTimeTick period, uint32_t cycles, Fn &&Fx, Args &&...Ax)
+    bool throttle(uint64_t key, RelativeTimeTick ticks, Fn &&Fx, Args &&...Ax)
     {
-        auto temp = new lattice{nullptr, nullptr, {0, 0, period.tick, cycles, std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}};
-        insert_lattice(time.tick, temp, 'c');
+        if (oversized<Fn, Args...>())
+        {
+            return false;
+        }
+        auto ok = arm_keyed(key, ticks.tick, 't', TaskSite::of<std::decay_t<Fn>>(), bind_task(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+        return ok && record('t', key, ticks.tick);
     }
 
-    template <class Fn, class... Args>
-    auto set_task(RelativeTimeTick time, void *, Fn &&Fx, Args &&...Ax)
-        -> std::future<typename std::result_of<Fn(Args...)>::type>
+    // called as (tick, op, key, ticks) for every relative one-shot set_task,
+    // debounce, throttle, cancel_keyed and cancel_all that took effect, in
+    // the terms of TimerEvent, so a live workload can be saved and fed to
+    // TimerReplay; periodic, absolute and async timers are not recorded, and
+    // of the task attributes only the owner is kept; an empty fn stops recording
+    using recorder_t = std::function<void(uint32_t tick, char op, uint64_t key, uint32_t ticks)>;
+    void set_recorder(recorder_t fn);
+
+    // starts recording the thread cpu time of every task per callable type;
+    // runs longer than budget (if non-zero) are counted as over budget
+    void enable_profiling(std::chrono::nanoseconds budget = std::chrono::nanoseconds(0));
+
+    void disable_profiling();
+
+    // the n callable types that used the most worker cpu time so far
+    std::vector<TaskCost> top_costs(size_t n) const;
+
+    // drops the pending debounce or throttle of key
+    bool cancel_keyed(uint64_t key);
+
+    // drops every timer of owner still in the wheel, returns how many; tasks
+    // already handed to the worker pool are skipped if they have not started,
+    // and a periodic one that is running does not re-arm
+    size_t cancel_all(OwnerID owner);
+
+    // at most per_tick tasks of cls are released per tick, up to burst after
+    // idle ticks; the excess stays in the wheel and is spread over the
+    // following ticks; per_tick 0 lifts the limit
+    void set_rate_limit(uint32_t cls, uint32_t per_tick, uint32_t burst = 0);
+
+    RateStats rate_stats(uint32_t cls);
+
+    // starts sampling how far ahead timers are armed, how many are cancelled
+    // before they expire and how many nodes cascading moves; a restart clears it
+    void start_wheel_profile();
+
+    void stop_wheel_profile();
+
+    // the samples so far with the cascade cost they imply, and the layout
+    // that would have cut it, for rebuild_wheel()
+    WheelProfile wheel_profile();
+
+    WheelLayout wheel_layout();
+
+    // relinks every pending timer into a wheel of the given layout, false if
+    // the layout cannot cover 32 bit ticks; allocates the new slot heads, so
+    // keep it off a real-time tick path
+    bool rebuild_wheel(const WheelLayout &layout);
+
+    uint32_t numa_nodes() const
     {
-        using rt = typename std::result_of<Fn(Args...)>::type;
-        auto task_ptr =
-            std::make_shared<std::packaged_task<rt()>>(std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
-        auto temp = new lattice{nullptr, nullptr, {0, 0, 0xFFFFFFFF, 1, [task_ptr]()
-                                                   { (*task_ptr)(); }}};
-        insert_lattice(time.tick, temp);
-        return task_ptr->get_future();
+        return static_cast<uint32_t>(topology.size());
     }
 
-    template <class Fn, class... Args>
-    auto set_task(AbsoluteTimeTick time, void *, Fn &&Fx, Args &&...Ax)
-        -> std::future<typename std::result_of<Fn(Args...)>::type>
+    // how often tasks and timer nodes were touched from another NUMA node
+    NumaStats numa_stats();
+
+    template <class... Args>
+    auto set_task(Args &&...Ax)
     {
-        using rt = typename std::result_of<Fn(Args...)>::type;
-        auto task_ptr =
-            std::make_shared<std::packaged_task<rt()>>(std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
-        auto temp = new lattice{nullptr, nullptr, {0, 0, 0xFFFFFFFF, 1, [task_ptr]()
-                                                   { (*task_ptr)(); }}};
-        insert_lattice(time.tick, temp, 'a');
-        return task_ptr->get_future();
+        return emplace_task(TaskAttr{}, std::forward<Args>(Ax)...);
     }
 
     // only for debug
     void print_self()
     {
         std::cout << "sizeof lattice: " << sizeof(lattice) << std::endl;
-        for (size_t i = 0; i < TWR_SIZE; i++)
+        for (size_t i = 0; i < tw_1st.size(); i++)
         {
             std::cout << "list " << std::setw(3) << i << " head: ";
             lattice *temp = tw_1st[i];
@@ -224,9 +526,9 @@ public:
             std::cout << "\n";
         }
         std::cout << "+++++++++++++++++++++++\n";
-        for (size_t j = 0; j < 4; j++)
+        for (size_t j = 0; j < tw_nth.size(); j++)
         {
-            for (size_t i = 0; i < TWN_SIZE; i++)
+            for (size_t i = 0; i < tw_nth[j].size(); i++)
             {
                 std::cout << "list " << std::setw(3) << i << " head: ";
                 lattice *temp = tw_nth[j][i];
@@ -244,33 +546,602 @@ public:
     }
 
 private:
-    lattice *calculate_lattice(uint32_t ticks, uint32_t current_ticks);
+    // an owner's pending nodes, a ring from first, and how many of its tasks
+    // are out in the pool; cancel_all moves gen on, which voids every task
+    // stamped with an older one
+    struct owner_slot
+    {
+        uint64_t key{};
+        lattice *first{};
+        uint32_t running{};
+        uint32_t gen{};
+
+        bool live() const
+        {
+            return first != nullptr || running != 0;
+        }
+    };
+
+    // open addressing table of debounce/throttle keys, a null node marks a tombstone
+    struct keyed_slot
+    {
+        uint64_t key{};
+        lattice *node{};
+        uint32_t window{};
+        char mode{};
+
+        bool live() const
+        {
+            return node != nullptr;
+        }
+    };
+
+    // a bare callable stays small enough for std::function to keep it inline,
+    // a std::bind result never does
+    template <class Fn, class... Args>
+    static std::function<void()> bind_task(Fn &&Fx, Args &&...Ax)
+    {
+        if constexpr (sizeof...(Args) == 0)
+        {
+            return std::forward<Fn>(Fx);
+        }
+        else
+        {
+            return std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...);
+        }
+    }
+
+    // what bind_task hands to std::function
+    template <class Fn, class... Args>
+    using bound_t = std::conditional_t<sizeof...(Args) == 0, std::decay_t<Fn>,
+                                       decltype(std::bind(std::declval<Fn>(), std::declval<Args>()...))>;
+
+    // a real-time profile refuses callables std::function would allocate
+    // for; libstdc++ and libc++ both keep a trivially copyable one of up to
+    // two pointers inline
+    template <class Fn, class... Args>
+    bool oversized() const
+    {
+        using bound = bound_t<Fn, Args...>;
+        return arena && !(std::is_trivially_copyable<bound>::value && sizeof(bound) <= 2 * sizeof(void *) &&
+                          alignof(bound) <= alignof(void *));
+    }
+
+    struct TaskAttr
+    {
+        uint64_t strand{};
+        uint64_t owner{};
+        uint32_t subtick{};
+        uint32_t rate_class{};
+        uint32_t home{~0u};
+    };
+
+    struct numa_group
+    {
+        // node the group's memory is bound to, -1 leaves placement to the kernel
+        int node{-1};
+        std::vector<int> cpus;
+    };
+
+    struct alignas(64) node_pool
+    {
+        std::mutex mtx;
+        lattice *free{};
+        std::vector<void *> slabs;
+    };
+
+    // trace clock of when go() spliced tick into a due list, so DISPATCH
+    // covers the wait there even if the pool claims the node ticks later
+    struct tick_mark
+    {
+        uint32_t tick{};
+        uint64_t stamp{};
+    };
+
+    constexpr static uint32_t TICK_MARKS = 64;
+
+    struct alignas(64) due_list
+    {
+        lattice *head{};
+        std::atomic<bool> ready{};
+        // the last TICK_MARKS splices, by tick; written and read under tw_mtx
+        tick_mark marks[TICK_MARKS];
+    };
+
+    struct rate_bucket
+    {
+        uint32_t per_tick{};
+        uint32_t burst{};
+        uint32_t tokens{};
+        uint32_t refill_tick{};
+        // latest tick handed out to deferred tasks and how many went to it,
+        // so overflow queues up behind earlier overflow
+        uint32_t cursor_tick{};
+        uint32_t cursor_used{};
+        uint64_t released{};
+        uint64_t deferred{};
+    };
+
+    struct wheel_samples
+    {
+        bool on{};
+        uint64_t armed[SPANS]{};
+        uint64_t cancelled[SPANS]{};
+        uint64_t fired{};
+        uint64_t moved{};
+    };
+
+    lattice *make_lattice(const TaskAttr &attr, TaskObj &&obj, uint32_t site = 0)
+    {
+        if (site != 0)
+        {
+            obj.site = site;
+        }
+        if (attr.strand != 0)
+        {
+            obj.strand = attr.strand;
+        }
+        if (attr.owner != 0)
+        {
+            obj.owner = attr.owner;
+        }
+        if (attr.subtick != 0)
+        {
+            obj.subtick = attr.subtick;
+        }
+        if (attr.rate_class != 0)
+        {
+            obj.rate_class = attr.rate_class;
+        }
+        if (attr.home != ~0u)
+        {
+            obj.home = attr.home;
+        }
+        return alloc_lattice(std::move(obj));
+    }
+
+    template <class... Args>
+    auto emplace_task(TaskAttr attr, StrandID strand, Args &&...Ax)
+    {
+        attr.strand = strand.key;
+        return emplace_task(attr, std::forward<Args>(Ax)...);
+    }
+
+    template <class... Args>
+    auto emplace_task(TaskAttr attr, OwnerID owner, Args &&...Ax)
+    {
+        attr.owner = owner.key;
+        return emplace_task(attr, std::forward<Args>(Ax)...);
+    }
+
+    template <class... Args>
+    auto emplace_task(TaskAttr attr, RateClass cls, Args &&...Ax)
+    {
+        attr.rate_class = cls.id;
+        return emplace_task(attr, std::forward<Args>(Ax)...);
+    }
+
+    template <class... Args>
+    auto emplace_task(TaskAttr attr, NumaNode node, Args &&...Ax)
+    {
+        attr.home = node.id;
+        return emplace_task(attr, std::forward<Args>(Ax)...);
+    }
+
+    template <class... Args>
+    auto emplace_task(TaskAttr attr, SubTick offset, Args &&...Ax)
+    {
+        attr.subtick = offset.offset;
+        return emplace_task(attr, std::forward<Args>(Ax)...);
+    }
+
+    bool emplace_task(const TaskAttr &attr, RelativeTimeTick time, TaskObj obj)
+    {
+        auto once = obj.counters == 1;
+        auto ok = insert_lattice(time.tick, make_lattice(attr, std::move(obj)));
+        return ok && (!once || record('s', attr.owner, time.tick));
+    }
+
+    bool emplace_task(const TaskAttr &attr, AbsoluteTimeTick time, TaskObj obj)
+    {
+        return insert_lattice(time.tick, make_lattice(attr, std::move(obj)), 'a');
+    }
+
+    template <class Fn, class... Args>
+    bool emplace_task(const TaskAttr &attr, RelativeTimeTick time, Fn &&Fx, Args &&...Ax)
+    {
+        if (oversized<Fn, Args...>())
+        {
+            return false;
+        }
+        auto temp = make_lattice(attr, {0, 0, 0xFFFFFFFF, 1, bind_task(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}, TaskSite::of<std::decay_t<Fn>>());
+        return insert_lattice(time.tick, temp) && record('s', attr.owner, time.tick);
+    }
+
+    template <class Fn, class... Args>
+    bool emplace_task(const TaskAttr &attr, AbsoluteTimeTick time, Fn &&Fx, Args &&...Ax)
+    {
+        if (oversized<Fn, Args...>())
+        {
+            return false;
+        }
+        auto temp = make_lattice(attr, {0, 0, 0xFFFFFFFF, 1, bind_task(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}, TaskSite::of<std::decay_t<Fn>>());
+        return insert_lattice(time.tick, temp, 'a');
+    }
+
+    template <class Fn, class... Args>
+    bool emplace_task(const TaskAttr &attr, RelativeTimeTick time, AbsoluteTimeTick period, uint32_t cycles, Fn &&Fx, Args &&...Ax)
+    {
+        if (oversized<Fn, Args...>())
+        {
+            return false;
+        }
+        auto temp = make_lattice(attr, {0, 0, period.tick, cycles, bind_task(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}, TaskSite::of<std::decay_t<Fn>>());
+        return insert_lattice(time.tick, temp);
+    }
+
+    template <class Fn, class... Args>
+    bool emplace_task(const TaskAttr &attr, AbsoluteTimeTick time, AbsoluteTimeTick period, uint32_t cycles, Fn &&Fx, Args &&...Ax)
+    {
+        if (oversized<Fn, Args...>())
+        {
+            return false;
+        }
+        auto temp = make_lattice(attr, {0, 0, period.tick, cycles, bind_task(std::forward<Fn>(Fx), std::forward<Args>(Ax)...)}, TaskSite::of<std::decay_t<Fn>>());
+        return insert_lattice(time.tick, temp, 'c');
+    }
+
+    template <class Fn, class... Args>
+    auto emplace_task(const TaskAttr &attr, RelativeTimeTick time, void *, Fn &&Fx, Args &&...Ax)
+        -> Completion<typename std::result_of<Fn(Args...)>::type>
+    {
+        using rt = typename std::result_of<Fn(Args...)>::type;
+        return emplace_async<rt>(attr, time.tick, 'r', TaskSite::of<std::decay_t<Fn>>(), std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+    }
+
+    template <class Fn, class... Args>
+    auto emplace_task(const TaskAttr &attr, AbsoluteTimeTick time, void *, Fn &&Fx, Args &&...Ax)
+        -> Completion<typename std::result_of<Fn(Args...)>::type>
+    {
+        using rt = typename std::result_of<Fn(Args...)>::type;
+        return emplace_async<rt>(attr, time.tick, 'a', TaskSite::of<std::decay_t<Fn>>(), std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+    }
+
+    template <class R, class Bound>
+    Completion<R> emplace_async(const TaskAttr &attr, uint32_t ticks, char isRelative, uint32_t site, Bound &&fn)
+    {
+        auto state = new BoundCompletion<R, std::decay_t<Bound>>(std::forward<Bound>(fn));
+        TaskObj obj{0, 0, 0xFFFFFFFF, 1};
+        obj.async = state;
+        auto temp = make_lattice(attr, std::move(obj), site);
+        if (temp == nullptr)
+        {
+            state->abandon();
+            return Completion<R>(state);
+        }
+        insert_lattice(ticks, temp, isRelative);
+        return Completion<R>(state);
+    }
+
+    // timer nodes carved per slab when a NUMA pool runs dry
+    constexpr static size_t SLAB = 256;
+
+    Scheduler(uint32_t current_time, std::chrono::nanoseconds resolution, bool simulated,
+              const NumaConfig *numa = nullptr);
+
+    void build_topology(const NumaConfig &config);
+
+    // NUMA node of the calling thread, 0 when unknown
+    uint32_t caller_group() const;
+
+    // true when first level slot index holds no timer in any of its lists
+    bool slot_empty(uint32_t index) const;
+
+    void tick_once();
+
+    // moves currtick forward by at most limit ticks without passing an armed
+    // timer or a first level wrap, returns the distance
+    uint32_t skip_idle(uint32_t limit);
+
+    bool wheel_empty() const;
+
+    // allocates empty slot heads for layout, the current ones must be gone
+    void init_wheel(const WheelLayout &layout);
+
+    static bool layout_valid(const WheelLayout &layout);
+
+    // estimated nodes moved per fired timer, taking cancelled timers to go
+    // before their slot is ever cascaded
+    static double layout_cost(const WheelLayout &layout, const uint64_t *armed, const uint64_t *cancelled);
+
+    static uint8_t span_of(uint32_t ticks)
+    {
+        return ticks == 0 ? 0 : static_cast<uint8_t>(32 - __builtin_clz(ticks));
+    }
+
+    void sample_arm(lattice *node, uint32_t relative_ticks)
+    {
+        if (samples.on)
+        {
+            node->span = span_of(relative_ticks);
+            samples.armed[node->span]++;
+        }
+    }
+
+    void sample_cancel(const lattice *node)
+    {
+        if (samples.on && node->span != 0xFF)
+        {
+            samples.cancelled[node->span]++;
+        }
+    }
+
+    // a first level slot keeps one list per NUMA node and one for sub-tick
+    // timers, node picks it
+    lattice *calculate_lattice(uint32_t ticks, uint32_t current_ticks, const lattice *node);
+
+    // list of first level slot index: NUMA node list, or topology.size() for sub-tick timers
+    size_t fst_slot(uint32_t index, uint32_t list) const
+    {
+        return index * (topology.size() + 1) + list;
+    }
+
+    // wheel a relative expiry lands in, 0 for tw_1st and 1 + i for tw_nth[i]
+    uint16_t wheel_level(uint32_t ticks) const;
 
     void move_lattice_cascade(lattice *head, uint32_t current_ticks);
 
-    void insert_lattice(uint32_t ticks, lattice *node, char isRelative = 'r');
+    // links node at the tail of pos, counted as a cascade move
+    void move_node(lattice *node, lattice *pos, uint32_t current_ticks);
+
+    // the slot tw_nth[level] cascades at its next wrap after current_ticks
+    lattice *next_cascade(size_t level, uint32_t current_ticks) const;
+
+    // where a node of next_cascade(level) goes in the lap of the level below
+    // that starts at the wrap: its slot there, or the stage for it while that
+    // slot is still ahead in the current lap
+    lattice *refine_lattice(const lattice *node, size_t level, uint32_t current_ticks);
+
+    // with max_cascade: moves what is left of the tick's budget out of the
+    // next_cascade slot of each level
+    void cascade_ahead(uint32_t current_ticks);
+
+    // the staging heads matching the current layout
+    void init_stage();
+
+    // true when nothing is staged for the next lap of first level slot index
+    bool stage_empty(uint32_t index) const;
+
+    bool insert_lattice(uint32_t ticks, lattice *node, char isRelative = 'r');
+
+    void link_lattice(lattice *node, uint32_t relative_ticks, uint32_t current_ticks);
+
+    void splice_lattice(lattice *from, lattice *to);
+
+    static lattice *sort_deadline(lattice *first);
+
+    // moves up to max due tasks into out under one hold of the wheel lock and
+    // returns their nodes to the allocator in bulk; sub-tick nodes met on the
+    // way go to the precise thread instead, and tasks of a busy strand are
+    // queued behind it, so the caller owns every strand in out
+    size_t claim_due(TaskObj *out, size_t max, uint32_t group = 0);
+
+    // false when the class of node is out of tokens, node is then linked
+    // again to a later tick
+    bool take_token(lattice *node, uint32_t current_ticks);
+
+    // start of tick for sub-tick deadlines, called from go()
+    int64_t tick_start_ns(uint32_t tick) const;
+
+    // takes the sub-tick list of a due first level slot off the wheel and
+    // hands it to the precise thread sorted by deadline
+    void hand_precise(lattice *head, uint32_t current_ticks);
+
+    // trace clock of that splice, for DISPATCH
+    uint64_t spliced_stamp(uint32_t tick, const due_list &list) const;
+
+    lattice *alloc_lattice(TaskObj &&obj);
+
+    lattice *alloc_pooled(TaskObj &&obj);
+
+    // adds a slab bound to the memory of group, with its pool lock held
+    bool grow_pool(uint32_t group);
+
+    // next-linked chain of cleared nodes back to the pools they came from
+    void release_pooled(lattice *first);
+
+    void free_lattice(lattice *node);
+
+    // next-linked chain, one allocator lock for all of it
+    void free_chain(lattice *first);
+
+    // false when neither the pool nor the wheel could take obj
+    bool dispatch(TaskObj &&obj);
+
+    bool arm_keyed(uint64_t key, uint32_t ticks, char mode, uint32_t site, std::function<void()> &&func);
+
+    // always true, so it chains after the operation it records
+    bool record(char op, uint64_t key, uint32_t ticks)
+    {
+        if (recording.load(std::memory_order_acquire))
+        {
+            record_event(op, key, ticks);
+        }
+        return true;
+    }
+
+    void record_event(char op, uint64_t key, uint32_t ticks);
+
+    void release_keyed(lattice *node, uint32_t current_ticks, bool fired);
+
+
+    void link_owner(lattice *node);
+
+    // the node leaves the wheel to run, its task stays counted to the owner
+    // until release_owner
+    void unlink_owner(lattice *node);
+
+    // with tw_mtx held: false once cancel_all has run for the task's owner
+    // since it was first armed
+    bool owner_current(const TaskObj &task);
+
+    bool owner_cancelled(const TaskObj &task);
+
+    void release_owner(uint64_t owner);
+
+    uint32_t next_expiry(uint32_t current_ticks) const;
+
+    void rearm_handle(uint32_t expired_tick);
+
+    // with tw_mtx held: points the timerfd at the nearest pending timer, or
+    // disarms it when there is none
+    void rearm_next();
 
 private:
-    tw_fst_t tw_1st;
-    tw_nth_t tw_nth[4];
+    uint32_t fst_bits{};
+    uint32_t nth_bits{};
+    uint32_t fst_mask{};
+    uint32_t nth_mask{};
+    // first level slots, each with its lists laid out as fst_slot() says
+    std::vector<lattice *> tw_1st;
+    std::vector<std::vector<lattice *>> tw_nth;
+    // next lap of each level as refined ahead by cascade_ahead, laid out
+    // like tw_1st and tw_nth; empty without max_cascade
+    std::vector<lattice *> stage_1st;
+    std::vector<std::vector<lattice *>> stage_nth;
+    uint32_t tick_moves{};
+    uint32_t peak_moves{};
+    wheel_samples samples;
     std::atomic_uint32_t currtick;
     std::mutex tw_mtx;
+    // expired slots spliced here by go(), one list per NUMA node, waiting for
+    // the pool threads of that node to claim them
+    std::unique_ptr<due_list[]> due;
     std::unique_ptr<Worker> workers;
+    KeyTable<owner_slot> owners;
+    KeyTable<keyed_slot> keyed;
+    std::vector<rate_bucket> rate_buckets;
+    std::atomic<bool> recording{};
+    std::mutex record_mtx;
+    recorder_t recorder;
+    RealtimeConfig rt_config;
+    std::unique_ptr<lattice[]> arena;
+    lattice *arena_free{};
+    std::mutex arena_mtx;
+    bool locked{};
+    // a single unbound node unless built from a NumaConfig
+    std::vector<numa_group> topology;
+    std::vector<uint32_t> cpu_group;
+    std::unique_ptr<node_pool[]> pools;
+    uint32_t group_threads{};
+    uint32_t tick_group{};
+    uint64_t local_moves{};
+    uint64_t remote_moves{};
+    std::chrono::nanoseconds tick_ns;
+    bool virtual_time{};
+    int timer_fd{-1};
+    int64_t epoch_ns{};
+    uint32_t epoch_tick{};
+    uint32_t armed_tick{};
+    bool armed{};
 };
 
 class Worker
 {
+    friend class Scheduler;
     constexpr static auto MAX_SIZE = 101;
+    // pool threads, per node under a NumaConfig unless it says otherwise
+    constexpr static size_t THREADS = 2;
+    // due tasks taken per claim of the wheel lock
+    constexpr static size_t CHUNK = 64;
 
 public:
-    explicit Worker(Scheduler &_tw);
+    // without threads every submitted task waits in ready for run_inline()
+    explicit Worker(Scheduler &_tw, bool threaded = true);
 
     ~Worker();
 
     bool submit(TaskObj &&obj);
 
+    // lets count tasks wait behind busy strands without allocating
+    void reserve_strands(size_t count);
+
+    // one wakeup for a batch of count submitted tasks
+    void notify(uint32_t count, uint32_t group = 0);
+
+    // takes a next-linked chain of sub-tick nodes sorted by deadline
+    void submit_precise(Scheduler::lattice *first, Scheduler::lattice *last);
+
 private:
-    void do_work();
+    // the precise thread sleeps until this close to a deadline, then spins
+    constexpr static int64_t SPIN_NS = 50000;
+
+    constexpr static uint32_t NO_CELL = ~0u;
+
+    // a task waiting behind the in-flight task of its strand; all strands
+    // share one pool of cells, so a backlog never grows a vector of its own
+    struct strand_cell
+    {
+        TaskObj task;
+        uint32_t next{NO_CELL};
+    };
+
+    // an active strand and its waiting cells, oldest first
+    struct strand_slot
+    {
+        uint64_t key{};
+        uint32_t head{NO_CELL};
+        uint32_t tail{NO_CELL};
+        bool active{};
+
+        bool live() const
+        {
+            return active;
+        }
+    };
+
+    void do_work(size_t slot);
+
+    // waits per the wake policy until the signal of group moves on from key
+    void await(uint32_t group, uint32_t key);
+
+    // pins the calling pool thread to the cpus of its NUMA node
+    void enter_group(uint32_t group);
+
+    void run_inline();
+
+    void run_chunk(TaskObj *chunk, size_t count, size_t slot);
+
+    // with mtx held: false if the strand is busy, task is then queued behind it
+    bool claim_strand(TaskObj &task);
+
+    void do_precise();
+
+    void execute(TaskObj &task, size_t slot);
+
+    bool release_strand(uint64_t strand, TaskObj &next);
+
+    // strand table, all with mtx held; key must not be active yet
+    void open_strand(uint64_t key);
+
+    void close_strand(strand_slot *slot);
+
+
+    void push_strand(strand_slot *slot, TaskObj &&task);
+
+    // false once the strand has nothing waiting
+    bool pop_strand(strand_slot *slot, TaskObj &task);
+
+    bool enqueue(TaskObj &&obj)
+    {
+        if ((rear + 2) % MAX_SIZE == front)
+        {
+            return false;
+        }
+        rear = (rear + 1) % MAX_SIZE;
+        queue[rear] = std::move(obj);
+        return true;
+    }
 
     int length() const
     {
@@ -279,12 +1150,44 @@ private:
 
 private:
     std::unique_ptr<TaskObj[]> queue;
+    // open addressing table of active strands, a strand turning busy and
+    // idle again never allocates once warmed up
+    KeyTable<strand_slot> strand_table;
+    std::vector<strand_cell> strand_cells;
+    uint32_t strand_free{NO_CELL};
     int front;
     int rear;
     bool stop;
     Scheduler &tw;
     std::vector<std::thread> thd;
     std::mutex mtx;
-    std::condition_variable cond;
+    // eventcount per NUMA node: bumped after work is queued, sleepers park on
+    // it with a futex and a notify only enters the kernel when somebody
+    // actually sleeps; also counts what the node's threads ran
+    struct alignas(64) lane
+    {
+        std::atomic<uint32_t> signal{};
+        std::atomic<uint32_t> sleepers{};
+        std::atomic<uint64_t> local_runs{};
+        std::atomic<uint64_t> remote_runs{};
+    };
+    std::unique_ptr<lane[]> lanes;
+    size_t per_group{THREADS};
+    std::atomic<WakePolicy> policy{WakePolicy::PARK};
+    std::atomic<uint32_t> spin_polls{};
+    std::atomic<uint32_t> yield_polls{};
+    // sub-tick nodes in deadline order, served by a thread started on first use
+    Scheduler::lattice *precise_first{};
+    Scheduler::lattice *precise_last{};
+    std::thread precise_thd;
+    std::condition_variable precise_cond;
+    // one cost table per pool thread plus the precise thread, made on first enable
+    std::vector<std::atomic<CostTable *>> costs;
+    std::atomic<bool> profiling{};
+    std::atomic<int64_t> budget_ns{};
+    // virtual clock: due tasks in dispatch order, touched only by the thread driving go()
+    bool inline_mode{};
+    std::deque<TaskObj> ready;
+    std::unique_ptr<TaskObj[]> inline_chunk;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,756 @@
+#include "sharedwheel.h"
+#if defined(__linux__)
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+constexpr uint32_t SHM_MAGIC = 0x54574d31;
+// fixed geometry, Scheduler's default WheelLayout; the first SENTINELS nodes
+// are the slot heads
+constexpr uint32_t TWR_BITS = 8;
+constexpr uint32_t TWN_BITS = 6;
+constexpr uint32_t TWR_SIZE = 1 << TWR_BITS;
+constexpr uint32_t TWN_SIZE = 1 << TWN_BITS;
+constexpr uint32_t TWR_MASK = TWR_SIZE - 1;
+constexpr uint32_t TWN_MASK = TWN_SIZE - 1;
+constexpr uint32_t SENTINELS = TWR_SIZE + 4 * TWN_SIZE;
+// the server checks for clients that died without detaching this often
+constexpr uint32_t REAP_TICKS = 1024;
+
+enum : uint32_t
+{
+    REQ_ARM = 1,
+    REQ_CANCEL,
+    REQ_DETACH,
+    DONE_FIRED,
+    DONE_CANCELLED
+};
+
+enum : uint8_t
+{
+    NODE_FREE,
+    NODE_ARMED,
+    NODE_DROPPED
+};
+
+constexpr uint32_t FST_IDX(uint32_t t)
+{
+    return t & TWR_MASK;
+}
+
+constexpr uint32_t NTH_IDX(uint32_t t, uint32_t n)
+{
+    return (t >> (TWR_BITS + n * TWN_BITS)) & TWN_MASK;
+}
+
+constexpr size_t align_up(size_t n)
+{
+    return (n + 63) & ~size_t(63);
+}
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared rings need address-free atomics");
+
+// what a client sends along with its eventfd
+struct attach_msg
+{
+    uint32_t slot;
+    uint32_t epoch;
+};
+} // namespace
+
+// links are node indices so the segment can sit at any address in each process
+struct shm_node
+{
+    uint32_t prev;
+    uint32_t next;
+    uint32_t expired;
+    uint16_t client;
+    uint16_t armed;
+};
+
+struct shm_record
+{
+    uint32_t op;
+    uint32_t node;
+    uint32_t ticks;
+};
+
+// single producer, single consumer; indices run freely and wrap by ring_size
+struct shm_ring
+{
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+};
+
+struct shm_client
+{
+    // 0 while the slot is free, claimed by a client with a compare and swap
+    std::atomic<int32_t> pid;
+    // set by the client once its eventfd is on the way to the wheel, 0 before
+    std::atomic<uint32_t> epoch;
+    uint32_t node_base;
+    uint32_t node_count;
+    shm_ring requests;
+    shm_ring completions;
+};
+
+struct shm_layout
+{
+    std::atomic<uint32_t> magic;
+    uint32_t capacity;
+    uint32_t clients;
+    uint32_t ring_size;
+    std::atomic<uint32_t> currtick;
+    uint64_t nodes_off;
+    uint64_t clients_off;
+    uint64_t records_off;
+
+    shm_node *nodes()
+    {
+        return reinterpret_cast<shm_node *>(reinterpret_cast<char *>(this) + nodes_off);
+    }
+
+    shm_client *client(uint32_t i)
+    {
+        return reinterpret_cast<shm_client *>(reinterpret_cast<char *>(this) + clients_off) + i;
+    }
+
+    // dir 0 holds the requests of client i, dir 1 its completions
+    shm_record *records(uint32_t i, uint32_t dir)
+    {
+        return reinterpret_cast<shm_record *>(reinterpret_cast<char *>(this) + records_off) + (i * 2 + dir) * ring_size;
+    }
+};
+
+static bool ring_push(shm_ring &ring, shm_record *recs, uint32_t size, const shm_record &rec)
+{
+    auto tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) == size)
+    {
+        return false;
+    }
+    recs[tail & (size - 1)] = rec;
+    ring.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+static bool ring_pop(shm_ring &ring, shm_record *recs, uint32_t size, shm_record &rec)
+{
+    auto head = ring.head.load(std::memory_order_relaxed);
+    if (head == ring.tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+    rec = recs[head & (size - 1)];
+    ring.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+#if defined(__linux__)
+// abstract unix socket named after the segment, gone with the last close
+static sockaddr_un socket_addr(const std::string &name, socklen_t &len)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    auto size = std::min(name.size(), sizeof(addr.sun_path) - 1);
+    name.copy(addr.sun_path + 1, size);
+    len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + size);
+    return addr;
+}
+
+SharedWheel::SharedWheel(const std::string &_name, const SharedWheelConfig &config) : name(_name)
+{
+    if (config.clients == 0 || config.capacity < config.clients || config.ring_size == 0 ||
+        (config.ring_size & (config.ring_size - 1)) != 0 || config.clients > 0xFFFF)
+    {
+        return;
+    }
+    auto nodes_off = align_up(sizeof(shm_layout));
+    auto clients_off = nodes_off + align_up(sizeof(shm_node) * (SENTINELS + static_cast<size_t>(config.capacity)));
+    auto records_off = clients_off + align_up(sizeof(shm_client) * config.clients);
+    length = records_off + sizeof(shm_record) * config.ring_size * 2 * static_cast<size_t>(config.clients);
+    socklen_t addr_len;
+    auto addr = socket_addr(name, addr_len);
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), addr_len) != 0 || listen(listen_fd, 64) != 0)
+    {
+        return;
+    }
+    auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return;
+    }
+    // a fresh segment reads as zeros, which is a valid empty state for every field
+    void *mem = ftruncate(fd, static_cast<off_t>(length)) == 0
+                    ? mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                    : MAP_FAILED;
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return;
+    }
+    auto layout = static_cast<shm_layout *>(mem);
+    layout->capacity = config.capacity;
+    layout->clients = config.clients;
+    layout->ring_size = config.ring_size;
+    layout->nodes_off = nodes_off;
+    layout->clients_off = clients_off;
+    layout->records_off = records_off;
+    auto nodes = layout->nodes();
+    for (uint32_t i = 0; i < SENTINELS; i++)
+    {
+        nodes[i].prev = i;
+        nodes[i].next = i;
+    }
+    auto share = config.capacity / config.clients;
+    for (uint32_t i = 0; i < config.clients; i++)
+    {
+        layout->client(i)->node_base = SENTINELS + i * share;
+        layout->client(i)->node_count = share;
+    }
+    backlog.resize(config.clients);
+    wake_fd.assign(config.clients, -1);
+    wake_epoch.assign(config.clients, 0);
+    dirty.assign(config.clients, false);
+    layout->magic.store(SHM_MAGIC, std::memory_order_release);
+    base = layout;
+}
+
+SharedWheel::~SharedWheel()
+{
+    if (listen_fd >= 0)
+    {
+        close(listen_fd);
+    }
+    if (base == nullptr)
+    {
+        return;
+    }
+    for (auto fd : wake_fd)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+    base->magic.store(0, std::memory_order_release);
+    munmap(base, length);
+    shm_unlink(name.c_str());
+}
+
+uint32_t SharedWheel::now() const
+{
+    return base != nullptr ? base->currtick.load(std::memory_order_acquire) : 0;
+}
+
+uint32_t SharedWheel::slot_of(uint32_t relative_ticks, uint32_t expired_tick) const
+{
+    if (relative_ticks < TWR_SIZE)
+    {
+        return FST_IDX(expired_tick);
+    }
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        uint64_t sz = 1ull << (TWR_BITS + (i + 1) * TWN_BITS);
+        if (relative_ticks < sz)
+        {
+            return TWR_SIZE + i * TWN_SIZE + NTH_IDX(expired_tick, i);
+        }
+    }
+    return TWR_SIZE + 3 * TWN_SIZE + NTH_IDX(expired_tick, 3);
+}
+
+void SharedWheel::link(uint32_t node, uint32_t relative_ticks, uint32_t current_ticks)
+{
+    auto nodes = base->nodes();
+    nodes[node].expired = current_ticks + relative_ticks;
+    auto head = slot_of(relative_ticks, nodes[node].expired);
+    nodes[node].prev = nodes[head].prev;
+    nodes[node].next = head;
+    nodes[nodes[head].prev].next = node;
+    nodes[head].prev = node;
+}
+
+void SharedWheel::unlink(uint32_t node)
+{
+    auto nodes = base->nodes();
+    nodes[nodes[node].next].prev = nodes[node].prev;
+    nodes[nodes[node].prev].next = nodes[node].next;
+}
+
+void SharedWheel::cascade(uint32_t head, uint32_t current_ticks)
+{
+    auto nodes = base->nodes();
+    while (nodes[head].next != head)
+    {
+        auto temp = nodes[head].next;
+        unlink(temp);
+        link(temp, nodes[temp].expired - current_ticks, current_ticks);
+    }
+}
+
+void SharedWheel::go()
+{
+    if (base == nullptr)
+    {
+        return;
+    }
+    accept_clients();
+    auto current_ticks = base->currtick.load(std::memory_order_relaxed);
+    for (uint32_t c = 0; c < base->clients; c++)
+    {
+        auto client = base->client(c);
+        auto pid = client->pid.load(std::memory_order_acquire);
+        if (pid == 0)
+        {
+            continue;
+        }
+        // a client that died between claiming the slot and publishing its
+        // epoch still holds the pid, so probe before looking at the epoch
+        if (current_ticks % REAP_TICKS == c % REAP_TICKS && kill(pid, 0) != 0 && errno == ESRCH)
+        {
+            purge(c);
+            continue;
+        }
+        if (client->epoch.load(std::memory_order_acquire) != 0)
+        {
+            drain_requests(c, current_ticks);
+        }
+    }
+    base->currtick.store(current_ticks + 1, std::memory_order_release);
+    auto index = FST_IDX(current_ticks);
+    if (index == 0)
+    {
+        uint32_t i = 0;
+        uint32_t tpx;
+        do
+        {
+            tpx = NTH_IDX(current_ticks + 1, i);
+            cascade(TWR_SIZE + i * TWN_SIZE + tpx, current_ticks);
+        } while (tpx == 0 && ++i < 4);
+    }
+    auto nodes = base->nodes();
+    while (nodes[index].next != index)
+    {
+        auto temp = nodes[index].next;
+        unlink(temp);
+        nodes[temp].armed = 0;
+        complete(nodes[temp].client, DONE_FIRED, temp);
+    }
+    for (uint32_t c = 0; c < base->clients; c++)
+    {
+        if (dirty[c] || !backlog[c].empty())
+        {
+            flush(c);
+        }
+    }
+}
+
+void SharedWheel::drain_requests(uint32_t c, uint32_t current_ticks)
+{
+    auto client = base->client(c);
+    auto nodes = base->nodes();
+    shm_record rec;
+    while (ring_pop(client->requests, base->records(c, 0), base->ring_size, rec))
+    {
+        // a client may only touch the nodes of its own share
+        auto owned = rec.node >= client->node_base && rec.node - client->node_base < client->node_count;
+        switch (rec.op)
+        {
+        case REQ_ARM:
+            if (owned && !nodes[rec.node].armed)
+            {
+                nodes[rec.node].armed = 1;
+                nodes[rec.node].client = static_cast<uint16_t>(c);
+                link(rec.node, rec.ticks, current_ticks);
+            }
+            break;
+        case REQ_CANCEL:
+            if (owned && nodes[rec.node].armed)
+            {
+                unlink(rec.node);
+                nodes[rec.node].armed = 0;
+                complete(c, DONE_CANCELLED, rec.node);
+            }
+            break;
+        case REQ_DETACH:
+            purge(c);
+            return;
+        default:
+            break;
+        }
+    }
+}
+
+void SharedWheel::complete(uint32_t c, uint32_t op, uint32_t node)
+{
+    dirty[c] = true;
+    if (backlog[c].empty() && ring_push(base->client(c)->completions, base->records(c, 1), base->ring_size, {op, node, 0}))
+    {
+        return;
+    }
+    backlog[c].push_back(op);
+    backlog[c].push_back(node);
+}
+
+void SharedWheel::flush(uint32_t c)
+{
+    auto client = base->client(c);
+    auto &pending = backlog[c];
+    while (!pending.empty() && ring_push(client->completions, base->records(c, 1), base->ring_size, {pending[0], pending[1], 0}))
+    {
+        pending.pop_front();
+        pending.pop_front();
+    }
+    if (dirty[c])
+    {
+        wake(c);
+        dirty[c] = false;
+    }
+}
+
+void SharedWheel::wake(uint32_t c)
+{
+    auto epoch = base->client(c)->epoch.load(std::memory_order_acquire);
+    if (wake_epoch[c] != epoch)
+    {
+        // attached after this tick's accept pass, its eventfd is queued by now
+        accept_clients();
+    }
+    if (wake_epoch[c] == epoch && wake_fd[c] >= 0)
+    {
+        uint64_t one = 1;
+        (void)write(wake_fd[c], &one, sizeof(one));
+    }
+}
+
+void SharedWheel::accept_clients()
+{
+    int conn;
+    while ((conn = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC)) >= 0)
+    {
+        // the client sends before it waits for anything, so this is short
+        timeval tv{0, 10000};
+        setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        attach_msg msg{};
+        iovec iov{&msg, sizeof(msg)};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr hdr{};
+        hdr.msg_iov = &iov;
+        hdr.msg_iovlen = 1;
+        hdr.msg_control = control;
+        hdr.msg_controllen = sizeof(control);
+        auto got = recvmsg(conn, &hdr, MSG_CMSG_CLOEXEC);
+        auto cmsg = CMSG_FIRSTHDR(&hdr);
+        close(conn);
+        if (got != sizeof(msg) || cmsg == nullptr || cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            continue;
+        }
+        int fd;
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+        if (msg.slot >= base->clients)
+        {
+            close(fd);
+            continue;
+        }
+        if (wake_fd[msg.slot] >= 0)
+        {
+            close(wake_fd[msg.slot]);
+        }
+        wake_fd[msg.slot] = fd;
+        wake_epoch[msg.slot] = msg.epoch;
+    }
+}
+
+void SharedWheel::purge(uint32_t c)
+{
+    auto client = base->client(c);
+    auto nodes = base->nodes();
+    for (uint32_t i = 0; i < client->node_count; i++)
+    {
+        auto node = client->node_base + i;
+        if (nodes[node].armed)
+        {
+            unlink(node);
+            nodes[node].armed = 0;
+        }
+    }
+    backlog[c].clear();
+    dirty[c] = false;
+    if (wake_fd[c] >= 0)
+    {
+        close(wake_fd[c]);
+        wake_fd[c] = -1;
+    }
+    wake_epoch[c] = 0;
+    client->requests.head.store(0, std::memory_order_relaxed);
+    client->requests.tail.store(0, std::memory_order_relaxed);
+    client->completions.head.store(0, std::memory_order_relaxed);
+    client->completions.tail.store(0, std::memory_order_relaxed);
+    client->epoch.store(0, std::memory_order_relaxed);
+    client->pid.store(0, std::memory_order_release);
+}
+
+SharedTimerClient::SharedTimerClient(const std::string &name)
+{
+    auto fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+    struct stat st{};
+    void *mem = fstat(fd, &st) == 0 && st.st_size > 0
+                    ? mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                    : MAP_FAILED;
+    close(fd);
+    if (mem == MAP_FAILED)
+    {
+        return;
+    }
+    length = static_cast<size_t>(st.st_size);
+    auto layout = static_cast<shm_layout *>(mem);
+    event_fd = layout->magic.load(std::memory_order_acquire) == SHM_MAGIC ? eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) : -1;
+    uint32_t claimed = layout->clients;
+    for (uint32_t i = 0; event_fd >= 0 && i < layout->clients; i++)
+    {
+        int32_t expected = 0;
+        if (layout->client(i)->pid.compare_exchange_strong(expected, getpid(), std::memory_order_acq_rel))
+        {
+            claimed = i;
+            break;
+        }
+    }
+    if (claimed == layout->clients)
+    {
+        if (event_fd >= 0)
+        {
+            close(event_fd);
+            event_fd = -1;
+        }
+        munmap(mem, length);
+        return;
+    }
+    auto client = layout->client(claimed);
+    static std::atomic<uint32_t> epochs{0};
+    auto epoch = ((static_cast<uint32_t>(getpid()) << 8) + ++epochs) | 1;
+    // hand the eventfd over first, the wheel only serves the slot once the epoch is set
+    socklen_t addr_len;
+    auto addr = socket_addr(name, addr_len);
+    auto sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    attach_msg msg{claimed, epoch};
+    iovec iov{&msg, sizeof(msg)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))]{};
+    msghdr hdr{};
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control;
+    hdr.msg_controllen = sizeof(control);
+    auto cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &event_fd, sizeof(int));
+    auto sent = sock >= 0 && connect(sock, reinterpret_cast<sockaddr *>(&addr), addr_len) == 0 &&
+                sendmsg(sock, &hdr, MSG_NOSIGNAL) == sizeof(msg);
+    if (sock >= 0)
+    {
+        close(sock);
+    }
+    if (!sent)
+    {
+        client->pid.store(0, std::memory_order_release);
+        close(event_fd);
+        event_fd = -1;
+        munmap(mem, length);
+        return;
+    }
+    client->epoch.store(epoch, std::memory_order_release);
+    slot = claimed;
+    node_base = client->node_base;
+    free_nodes.reserve(client->node_count);
+    for (uint32_t i = client->node_count; i-- > 0;)
+    {
+        free_nodes.push_back(node_base + i);
+    }
+    callbacks.resize(client->node_count);
+    state.assign(client->node_count, NODE_FREE);
+    base = layout;
+}
+
+SharedTimerClient::~SharedTimerClient()
+{
+    if (base == nullptr)
+    {
+        return;
+    }
+    // a full ring is retried briefly; if the server is gone the pid check
+    // reclaims the slot once this process exits
+    for (int i = 0; i < 1000 && base->magic.load(std::memory_order_acquire) == SHM_MAGIC; i++)
+    {
+        std::lock_guard<std::mutex> grd(mtx);
+        if (push_request(REQ_DETACH, 0, 0))
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    munmap(base, length);
+    close(event_fd);
+}
+
+uint32_t SharedTimerClient::now() const
+{
+    return base != nullptr ? base->currtick.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedTimerClient::push_request(uint32_t op, uint32_t node, uint32_t ticks)
+{
+    return ring_push(base->client(slot)->requests, base->records(slot, 0), base->ring_size, {op, node, ticks});
+}
+
+uint32_t SharedTimerClient::set_timer(RelativeTimeTick ticks, std::function<void()> fn)
+{
+    if (base == nullptr)
+    {
+        return 0;
+    }
+    std::lock_guard<std::mutex> grd(mtx);
+    if (free_nodes.empty())
+    {
+        return 0;
+    }
+    auto node = free_nodes.back();
+    if (!push_request(REQ_ARM, node, ticks.tick))
+    {
+        return 0;
+    }
+    free_nodes.pop_back();
+    callbacks[node - node_base] = std::move(fn);
+    state[node - node_base] = NODE_ARMED;
+    return node;
+}
+
+bool SharedTimerClient::cancel(uint32_t id)
+{
+    if (base == nullptr || id < node_base || id - node_base >= state.size())
+    {
+        return false;
+    }
+    std::lock_guard<std::mutex> grd(mtx);
+    auto i = id - node_base;
+    if (state[i] != NODE_ARMED || !push_request(REQ_CANCEL, id, 0))
+    {
+        return false;
+    }
+    state[i] = NODE_DROPPED;
+    callbacks[i] = nullptr;
+    return true;
+}
+
+size_t SharedTimerClient::process_ready()
+{
+    if (base == nullptr)
+    {
+        return 0;
+    }
+    uint64_t count;
+    while (read(event_fd, &count, sizeof(count)) > 0)
+    {
+    }
+    auto client = base->client(slot);
+    size_t ran = 0;
+    std::vector<std::function<void()>> due;
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> grd(mtx);
+            shm_record rec;
+            while (due.size() < 64 && ring_pop(client->completions, base->records(slot, 1), base->ring_size, rec))
+            {
+                auto i = rec.node - node_base;
+                if (rec.node < node_base || i >= state.size() || state[i] == NODE_FREE)
+                {
+                    continue;
+                }
+                if (rec.op == DONE_FIRED && state[i] == NODE_ARMED)
+                {
+                    due.push_back(std::move(callbacks[i]));
+                }
+                callbacks[i] = nullptr;
+                state[i] = NODE_FREE;
+                free_nodes.push_back(rec.node);
+            }
+        }
+        if (due.empty())
+        {
+            return ran;
+        }
+        // outside the lock, so callbacks may arm or cancel timers
+        for (auto &fn : due)
+        {
+            fn();
+        }
+        ran += due.size();
+        due.clear();
+    }
+}
+#else
+SharedWheel::SharedWheel(const std::string &_name, const SharedWheelConfig &) : name(_name)
+{
+}
+
+SharedWheel::~SharedWheel()
+{
+}
+
+uint32_t SharedWheel::now() const
+{
+    return 0;
+}
+
+void SharedWheel::go()
+{
+}
+
+SharedTimerClient::SharedTimerClient(const std::string &)
+{
+}
+
+SharedTimerClient::~SharedTimerClient()
+{
+}
+
+uint32_t SharedTimerClient::now() const
+{
+    return 0;
+}
+
+uint32_t SharedTimerClient::set_timer(RelativeTimeTick, std::function<void()>)
+{
+    return 0;
+}
+
+bool SharedTimerClient::cancel(uint32_t)
+{
+    return false;
+}
+
+size_t SharedTimerClient::process_ready()
+{
+    return 0;
+}
+#endif
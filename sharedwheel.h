@@ -0,0 +1,128 @@
+#ifndef USER_SHAREDWHEEL_HEADER
+#define USER_SHAREDWHEEL_HEADER
+
+#include "scheduler.h"
+#include <string>
+
+// one timing wheel per host in a POSIX shared memory segment: a single
+// SharedWheel process drives the ticks, any number of SharedTimerClient
+// processes arm and cancel through per-client lock-free rings and get their
+// expiries back through a completion ring plus an eventfd wakeup, handed to
+// the wheel over a unix socket when the client attaches
+struct SharedWheelConfig
+{
+    // timer nodes, split evenly between the client slots
+    uint32_t capacity{1 << 16};
+    uint32_t clients{16};
+    // requests and completions in flight per client, a power of two
+    uint32_t ring_size{4096};
+};
+
+struct shm_layout;
+
+class SharedWheel
+{
+public:
+    // creates the segment name ("/..."), which must not exist yet
+    explicit SharedWheel(const std::string &name, const SharedWheelConfig &config = {});
+    // unlinks the segment, attached clients keep their mapping but stop receiving expiries
+    ~SharedWheel();
+
+    SharedWheel(const SharedWheel &) = delete;
+    SharedWheel &operator=(const SharedWheel &) = delete;
+
+    bool valid() const
+    {
+        return base != nullptr;
+    }
+
+    // applies pending requests, expires one tick and wakes the owners of what fired
+    void go();
+
+    uint32_t now() const;
+
+private:
+    void link(uint32_t node, uint32_t relative_ticks, uint32_t current_ticks);
+
+    void unlink(uint32_t node);
+
+    uint32_t slot_of(uint32_t relative_ticks, uint32_t expired_tick) const;
+
+    void cascade(uint32_t head, uint32_t current_ticks);
+
+    void drain_requests(uint32_t client, uint32_t current_ticks);
+
+    // queues a completion, held back locally while the client's ring is full
+    void complete(uint32_t client, uint32_t op, uint32_t node);
+
+    void flush(uint32_t client);
+
+    void wake(uint32_t client);
+
+    // takes the eventfds of newly attached clients off the socket
+    void accept_clients();
+
+    void purge(uint32_t client);
+
+private:
+    std::string name;
+    shm_layout *base{};
+    size_t length{};
+    int listen_fd{-1};
+    // per client: completions waiting for ring space as op, node pairs, and
+    // its eventfd with the slot epoch it was received for
+    std::vector<std::deque<uint32_t>> backlog;
+    std::vector<int> wake_fd;
+    std::vector<uint32_t> wake_epoch;
+    std::vector<bool> dirty;
+};
+
+class SharedTimerClient
+{
+public:
+    // attaches to an existing segment and claims a free client slot
+    explicit SharedTimerClient(const std::string &name);
+    ~SharedTimerClient();
+
+    SharedTimerClient(const SharedTimerClient &) = delete;
+    SharedTimerClient &operator=(const SharedTimerClient &) = delete;
+
+    bool valid() const
+    {
+        return base != nullptr;
+    }
+
+    // id for cancel, 0 if no node is free or the request ring is full
+    uint32_t set_timer(RelativeTimeTick ticks, std::function<void()> fn);
+
+    // the callback will not run after this returns true, even if the
+    // expiry is already on its way back
+    bool cancel(uint32_t id);
+
+    // eventfd that turns readable when completions are waiting
+    int native_handle() const
+    {
+        return event_fd;
+    }
+
+    // runs the callbacks of fired timers on the calling thread, returns how many
+    size_t process_ready();
+
+    uint32_t now() const;
+
+private:
+    bool push_request(uint32_t op, uint32_t node, uint32_t ticks);
+
+private:
+    shm_layout *base{};
+    size_t length{};
+    uint32_t slot{};
+    int event_fd{-1};
+    uint32_t node_base{};
+    std::mutex mtx;
+    std::vector<uint32_t> free_nodes;
+    std::vector<std::function<void()>> callbacks;
+    // free, armed, or cancelled by us with the completion still outstanding
+    std::vector<uint8_t> state;
+};
+#endif
@@ -0,0 +1,114 @@
+#include "taskcost.h"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+static std::mutex site_mtx;
+
+static std::vector<std::string> &site_names()
+{
+    // function local so sites may enroll during static initialisation
+    static std::vector<std::string> names{"unknown"};
+    return names;
+}
+
+uint32_t TaskSite::enroll(const char *mangled)
+{
+    std::string name = mangled;
+#if defined(__GNUG__)
+    int status = 0;
+    if (auto demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status))
+    {
+        name = demangled;
+        std::free(demangled);
+    }
+#endif
+    std::lock_guard<std::mutex> grd(site_mtx);
+    auto &names = site_names();
+    if (names.size() >= MAX_SITES)
+    {
+        return 0;
+    }
+    names.push_back(std::move(name));
+    return static_cast<uint32_t>(names.size() - 1);
+}
+
+std::string TaskSite::name(uint32_t id)
+{
+    std::lock_guard<std::mutex> grd(site_mtx);
+    auto &names = site_names();
+    return id < names.size() ? names[id] : names[0];
+}
+
+void CostTable::record(uint32_t site, uint64_t ns, bool over)
+{
+    auto &ele = sites[site < TaskSite::MAX_SITES ? site : 0];
+    size_t bucket = 0;
+    while (bucket + 1 < BUCKETS && (ns >> (bucket + 1)) != 0)
+    {
+        bucket++;
+    }
+    ele.count.store(ele.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    ele.total_ns.store(ele.total_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > ele.max_ns.load(std::memory_order_relaxed))
+    {
+        ele.max_ns.store(ns, std::memory_order_relaxed);
+    }
+    if (over)
+    {
+        ele.over_budget.store(ele.over_budget.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    ele.buckets[bucket].store(ele.buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::vector<TaskCost> CostTable::top(const std::vector<const CostTable *> &tables, size_t n)
+{
+    std::vector<TaskCost> rows;
+    for (uint32_t id = 0; id < TaskSite::MAX_SITES; id++)
+    {
+        TaskCost row{};
+        uint64_t hist[BUCKETS]{};
+        for (auto table : tables)
+        {
+            auto &ele = table->sites[id];
+            row.count += ele.count.load(std::memory_order_relaxed);
+            row.total_ns += ele.total_ns.load(std::memory_order_relaxed);
+            row.max_ns = std::max<uint64_t>(row.max_ns, ele.max_ns.load(std::memory_order_relaxed));
+            row.over_budget += ele.over_budget.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < BUCKETS; b++)
+            {
+                hist[b] += ele.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+        if (row.count == 0)
+        {
+            continue;
+        }
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BUCKETS; b++)
+        {
+            seen += hist[b];
+            if (row.p50_ns == 0 && seen * 2 >= row.count)
+            {
+                row.p50_ns = 2ull << b;
+            }
+            if (seen * 100 >= row.count * 99)
+            {
+                row.p99_ns = 2ull << b;
+                break;
+            }
+        }
+        row.site = TaskSite::name(id);
+        rows.push_back(std::move(row));
+    }
+    std::sort(rows.begin(), rows.end(), [](const TaskCost &a, const TaskCost &b)
+              { return a.total_ns > b.total_ns; });
+    if (rows.size() > n)
+    {
+        rows.resize(n);
+    }
+    return rows;
+}
@@ -0,0 +1,66 @@
+#ifndef USER_TASKCOST_HEADER
+#define USER_TASKCOST_HEADER
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+// dense ids for callable types, assigned the first time a type is scheduled;
+// id 0 collects tasks of unknown type and every type past MAX_SITES
+class TaskSite
+{
+public:
+    constexpr static uint32_t MAX_SITES = 512;
+
+    template <class Fn>
+    static uint32_t of()
+    {
+        static const uint32_t id = enroll(typeid(Fn).name());
+        return id;
+    }
+
+    static std::string name(uint32_t id);
+
+private:
+    static uint32_t enroll(const char *mangled);
+};
+
+struct TaskCost
+{
+    std::string site;
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    // upper bounds of the log2 histogram buckets holding the percentiles
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t over_budget;
+};
+
+// per-thread cpu cost of every site; written by one thread only, so plain
+// relaxed load/store pairs suffice and readers may merge at any time
+class CostTable
+{
+    constexpr static size_t BUCKETS = 40;
+
+    struct entry
+    {
+        std::atomic<uint64_t> count{};
+        std::atomic<uint64_t> total_ns{};
+        std::atomic<uint64_t> max_ns{};
+        std::atomic<uint64_t> over_budget{};
+        std::atomic<uint32_t> buckets[BUCKETS]{};
+    };
+
+public:
+    void record(uint32_t site, uint64_t ns, bool over);
+
+    // merges the tables and returns the n sites with the most cpu time
+    static std::vector<TaskCost> top(const std::vector<const CostTable *> &tables, size_t n);
+
+private:
+    entry sites[TaskSite::MAX_SITES];
+};
+#endif
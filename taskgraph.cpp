@@ -0,0 +1,146 @@
+#include "taskgraph.h"
+
+TaskGraph::node_id TaskGraph::add_node(uint32_t earliest, char timing, uint32_t site, std::function<void()> &&func)
+{
+    auto &ele = nodes.emplace_back();
+    ele.func = std::move(func);
+    ele.site = site;
+    ele.earliest = earliest;
+    ele.timing = timing;
+    return nodes.size() - 1;
+}
+
+void TaskGraph::precede(node_id before, node_id after)
+{
+    nodes[before].successors.push_back(after);
+    nodes[after].indegree++;
+}
+
+bool TaskGraph::launch()
+{
+    if (!done() || nodes.empty())
+    {
+        return false;
+    }
+    // Kahn's pass, a cycle would leave nodes that never become ready
+    std::vector<uint32_t> degree(nodes.size());
+    std::vector<node_id> ready;
+    for (node_id i = 0; i < nodes.size(); i++)
+    {
+        degree[i] = nodes[i].indegree;
+        if (degree[i] == 0)
+        {
+            ready.push_back(i);
+        }
+    }
+    size_t visited = 0;
+    while (visited < ready.size())
+    {
+        for (auto succ : nodes[ready[visited++]].successors)
+        {
+            if (--degree[succ] == 0)
+            {
+                ready.push_back(succ);
+            }
+        }
+    }
+    if (visited != nodes.size())
+    {
+        return false;
+    }
+    auto current_ticks = tw.now();
+    for (auto &ele : nodes)
+    {
+        ele.start_tick = ele.timing == 'r' ? current_ticks + ele.earliest : ele.earliest;
+        ele.pending.store(ele.indegree, std::memory_order_relaxed);
+        ele.dropped.store(false, std::memory_order_relaxed);
+    }
+    failures.store(0, std::memory_order_relaxed);
+    remaining.store(static_cast<uint32_t>(nodes.size()), std::memory_order_release);
+    bool armed = true;
+    for (node_id i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i].indegree == 0)
+        {
+            armed = arm(i) && armed;
+        }
+    }
+    return armed;
+}
+
+void TaskGraph::wait() const
+{
+    auto left = remaining.load(std::memory_order_acquire);
+    while (left != 0)
+    {
+        futex_wait(remaining, left);
+        left = remaining.load(std::memory_order_acquire);
+    }
+}
+
+bool TaskGraph::arm(node_id id)
+{
+    auto &ele = nodes[id];
+    TaskObj obj{0, 0, 0xFFFFFFFF, 1, [this, id]()
+                { run_node(id); }};
+    obj.site = ele.site;
+    bool armed;
+    if (ele.timing != 0 && static_cast<int32_t>(ele.start_tick - tw.now()) > 0)
+    {
+        armed = tw.insert_lattice(ele.start_tick, tw.alloc_lattice(std::move(obj)), 'n');
+    }
+    else
+    {
+        armed = tw.dispatch(std::move(obj));
+    }
+    if (!armed)
+    {
+        drop(id);
+    }
+    return armed;
+}
+
+void TaskGraph::drop(node_id id)
+{
+    // a successor of a dropped node never sees its pending count reach 0,
+    // so it is settled here instead; the flag keeps a shared successor
+    // from being counted twice
+    std::vector<node_id> stack{id};
+    nodes[id].dropped.store(true, std::memory_order_relaxed);
+    uint32_t count = 0;
+    while (!stack.empty())
+    {
+        auto cur = stack.back();
+        stack.pop_back();
+        count++;
+        for (auto succ : nodes[cur].successors)
+        {
+            if (!nodes[succ].dropped.exchange(true, std::memory_order_acq_rel))
+            {
+                stack.push_back(succ);
+            }
+        }
+    }
+    failures.fetch_add(count, std::memory_order_acq_rel);
+    if (remaining.fetch_sub(count, std::memory_order_acq_rel) == count)
+    {
+        futex_wake_all(remaining);
+    }
+}
+
+void TaskGraph::run_node(node_id id)
+{
+    auto &ele = nodes[id];
+    ele.func();
+    for (auto succ : ele.successors)
+    {
+        if (nodes[succ].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            arm(succ);
+        }
+    }
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        futex_wake_all(remaining);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef USER_TASKGRAPH_HEADER
+#define USER_TASKGRAPH_HEADER
+
+#include "scheduler.h"
+
+// dependency graph of timed tasks; a node is armed in the wheel only when all
+// of its predecessors have finished, so no thread ever blocks on a dependency
+class TaskGraph
+{
+    struct node
+    {
+        std::function<void()> func;
+        std::vector<size_t> successors;
+        uint32_t indegree{};
+        uint32_t earliest{};
+        // 0 when unconstrained, 'r' relative to launch, 'a' absolute tick
+        char timing{};
+        uint32_t start_tick{};
+        uint32_t site{};
+        std::atomic<uint32_t> pending{};
+        // set once the node can no longer run in this launch
+        std::atomic<bool> dropped{};
+    };
+
+public:
+    using node_id = size_t;
+
+    explicit TaskGraph(Scheduler &_tw) : tw(_tw) {}
+
+    template <class Fn, class... Args>
+    node_id add(Fn &&Fx, Args &&...Ax)
+    {
+        return add_node(0, 0, TaskSite::of<std::decay_t<Fn>>(), std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+    }
+
+    template <class Fn, class... Args>
+    node_id add(RelativeTimeTick earliest, Fn &&Fx, Args &&...Ax)
+    {
+        return add_node(earliest.tick, 'r', TaskSite::of<std::decay_t<Fn>>(), std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+    }
+
+    template <class Fn, class... Args>
+    node_id add(AbsoluteTimeTick earliest, Fn &&Fx, Args &&...Ax)
+    {
+        return add_node(earliest.tick, 'a', TaskSite::of<std::decay_t<Fn>>(), std::bind(std::forward<Fn>(Fx), std::forward<Args>(Ax)...));
+    }
+
+    // after may only start once before has finished
+    void precede(node_id before, node_id after);
+
+    // arms every root; false if the graph is still running or has a cycle, or
+    // if a root could not be armed, in which case the rest still runs
+    bool launch();
+
+    bool done() const
+    {
+        return remaining.load(std::memory_order_acquire) == 0;
+    }
+
+    // returns once every node has run or been dropped
+    void wait() const;
+
+    // nodes of the last launch that never ran because they, or one of their
+    // predecessors, found no timer node or pool slot
+    uint32_t failed() const
+    {
+        return failures.load(std::memory_order_acquire);
+    }
+
+    size_t size() const
+    {
+        return nodes.size();
+    }
+
+private:
+    node_id add_node(uint32_t earliest, char timing, uint32_t site, std::function<void()> &&func);
+
+    // false when the node could not be armed, it is dropped then
+    bool arm(node_id id);
+
+    // settles id and every successor that can no longer run
+    void drop(node_id id);
+
+    void run_node(node_id id);
+
+private:
+    Scheduler &tw;
+    std::deque<node> nodes;
+    mutable std::atomic<uint32_t> remaining{0};
+    std::atomic<uint32_t> failures{0};
+};
+#endif
@@ -0,0 +1,110 @@
+#include "tasktrace.h"
+#include <chrono>
+#include <mutex>
+
+std::atomic<bool> TaskTrace::active{false};
+
+static std::mutex trace_mtx;
+// stamp/ns pair taken at enable() to turn cycle counts into time on dump
+static uint64_t calib_stamp;
+static int64_t calib_ns;
+
+static int64_t trace_now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+std::vector<std::unique_ptr<TaskTrace::ring>> &TaskTrace::rings()
+{
+    // rings outlive their threads so a dump still sees finished workers
+    static std::vector<std::unique_ptr<ring>> all;
+    return all;
+}
+
+TaskTrace::ring *TaskTrace::enroll()
+{
+    auto r = std::make_unique<ring>();
+    std::lock_guard<std::mutex> grd(trace_mtx);
+    auto &all = rings();
+    r->index = all.size() + 1;
+    all.push_back(std::move(r));
+    return all.back().get();
+}
+
+void TaskTrace::enable(bool on)
+{
+    if (on)
+    {
+        std::lock_guard<std::mutex> grd(trace_mtx);
+        calib_stamp = stamp();
+        calib_ns = trace_now_ns();
+    }
+    active.store(on, std::memory_order_relaxed);
+}
+
+void TaskTrace::dump_chrome(std::ostream &os)
+{
+    std::lock_guard<std::mutex> grd(trace_mtx);
+    auto now_stamp = stamp();
+    auto now_ns = trace_now_ns();
+    double scale = now_stamp != calib_stamp
+                       ? static_cast<double>(now_ns - calib_ns) / static_cast<double>(now_stamp - calib_stamp)
+                       : 1.0;
+    static const char *names[] = {"arm", "cascade", "dispatch", "run", "run"};
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    std::vector<event> copy;
+    for (auto &r : rings())
+    {
+        auto head = r->head.load(std::memory_order_acquire);
+        auto begin = head > CAPACITY ? head - CAPACITY : 0;
+        copy.assign(r->events, r->events + CAPACITY);
+        // drop whatever the owner thread overwrote while we were copying,
+        // and the slot of event after, which it may be writing right now
+        auto after = r->head.load(std::memory_order_acquire);
+        if (after >= CAPACITY && after - CAPACITY + 1 > begin)
+        {
+            begin = after - CAPACITY + 1;
+        }
+        for (auto i = begin; i < head; i++)
+        {
+            auto &ev = copy[i & MASK];
+            auto us = (static_cast<double>(static_cast<int64_t>(ev.stamp - calib_stamp)) * scale) / 1000.0;
+            const char *phase = "i";
+            switch (ev.kind)
+            {
+            case DISPATCH:
+                phase = "b";
+                break;
+            case START:
+                // close the queue wait on this thread, then open the run slice
+                os << (first ? "" : ",") << "{\"name\":\"queued\",\"cat\":\"task\",\"ph\":\"e\",\"id\":" << ev.task
+                   << ",\"ts\":" << us << ",\"pid\":1,\"tid\":" << r->index << "}";
+                first = false;
+                phase = "B";
+                break;
+            case END:
+                phase = "E";
+                break;
+            default:
+                break;
+            }
+            os << (first ? "" : ",") << "{\"name\":\"" << (ev.kind == DISPATCH ? "queued" : names[ev.kind])
+               << "\",\"cat\":\"task\",\"ph\":\"" << phase << "\",\"ts\":" << us
+               << ",\"pid\":1,\"tid\":" << r->index;
+            if (ev.kind == DISPATCH)
+            {
+                os << ",\"id\":" << ev.task;
+            }
+            if (ev.kind == ARM || ev.kind == CASCADE)
+            {
+                os << ",\"s\":\"t\"";
+            }
+            os << ",\"args\":{\"task\":" << ev.task << ",\"tick\":" << ev.tick << ",\"level\":" << ev.arg << "}}";
+            first = false;
+        }
+    }
+    os << "]}\n";
+}
@@ -0,0 +1,125 @@
+#ifndef USER_TASKTRACE_HEADER
+#define USER_TASKTRACE_HEADER
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// task lifecycle tracing into per-thread rings; compiled out unless
+// SCHD_ENABLE_TRACE is defined, and a single relaxed load when disabled at runtime
+class TaskTrace
+{
+public:
+    enum kind : uint16_t
+    {
+        ARM,
+        CASCADE,
+        DISPATCH,
+        START,
+        END
+    };
+
+    struct event
+    {
+        uint64_t stamp;
+        uint64_t task;
+        uint32_t tick;
+        uint16_t kind;
+        uint16_t arg;
+    };
+
+    static void enable(bool on);
+
+    static bool enabled()
+    {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    // unique per thread without any shared counter
+    static uint64_t next_id()
+    {
+        auto &r = local();
+        return (r.index << 40) | ++r.issued;
+    }
+
+    static void record(kind k, uint64_t task, uint32_t tick, uint16_t arg = 0)
+    {
+        record_at(k, task, tick, arg, stamp());
+    }
+
+    // for an event that happened earlier on another thread, at time at of stamp()
+    static void record_at(kind k, uint64_t task, uint32_t tick, uint16_t arg, uint64_t at)
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        auto &r = local();
+        auto head = r.head.load(std::memory_order_relaxed);
+        r.events[head & MASK] = event{at, task, tick, k, arg};
+        r.head.store(head + 1, std::memory_order_release);
+    }
+
+    static uint64_t stamp()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    // writes every retained event as Chrome trace JSON, which Perfetto also loads
+    static void dump_chrome(std::ostream &os);
+
+private:
+    constexpr static uint64_t CAPACITY = 1 << 16;
+    constexpr static uint64_t MASK = CAPACITY - 1;
+
+    struct ring
+    {
+        uint64_t index{};
+        uint64_t issued{};
+        std::atomic<uint64_t> head{};
+        event events[CAPACITY];
+    };
+
+    static ring &local()
+    {
+        thread_local ring *r = enroll();
+        return *r;
+    }
+
+    static ring *enroll();
+
+    static std::vector<std::unique_ptr<ring>> &rings();
+
+    static std::atomic<bool> active;
+};
+
+#if defined(SCHD_ENABLE_TRACE)
+#define SCHD_TRACE(k, task, tick, arg) TaskTrace::record(TaskTrace::k, task, tick, arg)
+#define SCHD_TRACE_AT(k, task, tick, arg, at) TaskTrace::record_at(TaskTrace::k, task, tick, arg, at)
+#define SCHD_TRACE_STAMP() (TaskTrace::enabled() ? TaskTrace::stamp() : 0)
+#define SCHD_TRACE_ID(obj)                                       \
+    do                                                           \
+    {                                                            \
+        if ((obj).trace_id == 0 && TaskTrace::enabled())         \
+        {                                                        \
+            (obj).trace_id = TaskTrace::next_id();               \
+        }                                                        \
+    } while (0)
+#else
+#define SCHD_TRACE(k, task, tick, arg) ((void)0)
+#define SCHD_TRACE_AT(k, task, tick, arg, at) ((void)0)
+#define SCHD_TRACE_STAMP() uint64_t{0}
+#define SCHD_TRACE_ID(obj) ((void)0)
+#endif
+#endif
@@ -0,0 +1,72 @@
+// runs a NUMA scheduler over more nodes than the machine has, so they are
+// emulated on its cpus, and checks that timers reach the pool threads of
+// their home node and that cancels and strands keep working across nodes
+#include "scheduler.h"
+
+int main()
+{
+    constexpr uint32_t NODES = 3;
+    Scheduler tw(NumaConfig{NODES, 2});
+    auto nodes = tw.numa_nodes();
+    if (nodes < 2)
+    {
+        printf("FAIL: %u nodes, wanted at least 2\n", nodes);
+        return 1;
+    }
+    std::atomic<int> done{0};
+    std::atomic<bool> stop{false};
+    std::thread ticker([&]()
+                       {
+                           while (!stop)
+                           {
+                               tw.go();
+                               std::this_thread::sleep_for(std::chrono::microseconds(200));
+                           } });
+    constexpr int COUNT = 20000;
+    auto count = [&]() { done++; };
+    for (int i = 0; i < COUNT; i++)
+    {
+        uint32_t delay = (i * 7919u) % 3000 + 1;
+        auto home = NumaNode{static_cast<uint32_t>(i) % nodes};
+        if (i % 3 == 0)
+        {
+            tw.set_task(home, RelativeTimeTick{delay}, TaskObj{0, 0, 0xFFFFFFFF, 1, count});
+        }
+        else if (i % 3 == 1)
+        {
+            tw.set_task(OwnerID{9}, home, RelativeTimeTick{delay}, TaskObj{0, 0, 0xFFFFFFFF, 1, count});
+        }
+        else
+        {
+            tw.set_task(StrandID{static_cast<uint64_t>(i % 7) + 1}, home, RelativeTimeTick{delay},
+                        TaskObj{0, 0, 0xFFFFFFFF, 1, count});
+        }
+    }
+    auto cancelled = tw.cancel_all(OwnerID{9});
+    int expect = COUNT - static_cast<int>(cancelled);
+    for (int i = 0; i < 10000 && done < expect; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stop = true;
+    ticker.join();
+    auto stats = tw.numa_stats();
+    printf("nodes %u, ran %d of %d, cancelled %zu, runs local %llu remote %llu (%.3f), moves local %llu remote %llu (%.3f)\n",
+           stats.nodes, done.load(), expect, cancelled, static_cast<unsigned long long>(stats.local_runs),
+           static_cast<unsigned long long>(stats.remote_runs), stats.remote_run_ratio,
+           static_cast<unsigned long long>(stats.local_moves), static_cast<unsigned long long>(stats.remote_moves),
+           stats.remote_move_ratio);
+    if (done != expect || cancelled == 0)
+    {
+        printf("FAIL: timers lost or not cancelled\n");
+        return 1;
+    }
+    // a strand handed back to the shared ring may run on any node, plain
+    // timers only ever on their own
+    if (stats.local_runs < static_cast<uint64_t>(COUNT / 3))
+    {
+        printf("FAIL: timers ran away from their home node\n");
+        return 1;
+    }
+    return 0;
+}
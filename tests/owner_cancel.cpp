@@ -0,0 +1,43 @@
+// cancel_all must also stop owner tasks that already left the wheel: a
+// periodic timer cancelled while it runs does not re-arm, and a task queued
+// in a strand backlog behind a busy one is skipped
+#include "scheduler.h"
+
+int main()
+{
+    Scheduler tw;
+    std::atomic<int> cycles{0};
+    tw.set_task(OwnerID{5}, RelativeTimeTick{1}, AbsoluteTimeTick{1}, 100u, [&]() {
+        if (++cycles == 10)
+        {
+            tw.cancel_all(OwnerID{5});
+        }
+    });
+
+    std::atomic<bool> blocking{false}, release{false}, late{false};
+    tw.set_task(StrandID{3}, RelativeTimeTick{1}, [&]() {
+        blocking = true;
+        while (!release)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    tw.set_task(StrandID{3}, OwnerID{6}, RelativeTimeTick{1}, [&]() { late = true; });
+    for (int i = 0; i < 1000 && !blocking; i++)
+    {
+        tw.go();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    tw.cancel_all(OwnerID{6});
+    release = true;
+
+    for (int i = 0; i < 200; i++)
+    {
+        tw.go();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // both owners are done with, so their entries are gone
+    auto left = tw.cancel_all(OwnerID{5}) + tw.cancel_all(OwnerID{6});
+    printf("periodic ran %d of 10 cycles, backlog task ran %d, left %zu\n", cycles.load(), late.load(), left);
+    return cycles != 10 || late || !blocking || left != 0;
+}
@@ -0,0 +1,144 @@
+// churns a real-time profile scheduler with plain, strand, periodic, owner
+// tagged, debounce and throttle tasks and checks that once warmed up it
+// neither allocates nor takes a page fault, and that no go() moves more than
+// max_cascade nodes
+#include "scheduler.h"
+#include <sys/resource.h>
+#include <cstdlib>
+
+static std::atomic<long> allocs{0};
+
+void *operator new(size_t n)
+{
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(n))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+static long minor_faults()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+struct count_task
+{
+    std::atomic<long> *ran;
+    void operator()() const
+    {
+        ran->fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+int main()
+{
+    RealtimeConfig config;
+    config.capacity = 4096;
+    config.max_dispatch = 64;
+    // 4096 pending timers fit in 64 moves over the 256 ticks of a lap
+    config.max_cascade = 64;
+    Scheduler tw(config);
+    std::atomic<long> ran{0};
+    std::atomic<long> periodic_ran{0};
+    std::atomic<long> keyed_ran{0};
+    long armed = 0;
+    long periodic_armed = 0;
+    count_task task{&ran};
+    count_task periodic{&periodic_ran};
+    count_task keyed{&keyed_ran};
+    auto round = [&](uint32_t k)
+    {
+        for (uint32_t i = 0; i < 64; i++)
+        {
+            armed += tw.set_task(RelativeTimeTick((i * 37 + k) % 700), task);
+        }
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            armed += tw.set_task(StrandID{1 + i % 2}, RelativeTimeTick(1 + i), TaskObj{0, 0, 0xFFFFFFFF, 1, task});
+        }
+        periodic_armed += tw.set_task(RelativeTimeTick(1), AbsoluteTimeTick(5), static_cast<uint32_t>(3), periodic);
+        // every round is an owner of its own; the one from 40 rounds back
+        // still has all of its timers in the wheel when it is cancelled
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            armed += tw.set_task(OwnerID{k + 1}, RelativeTimeTick(300 + (i * 500 + k) % 1000), task);
+        }
+        if (k >= 40)
+        {
+            armed -= static_cast<long>(tw.cancel_all(OwnerID{k - 39}));
+        }
+        tw.debounce(1 + k % 16, RelativeTimeTick(5), keyed);
+        tw.throttle(100 + k % 16, RelativeTimeTick(3), keyed);
+        tw.go();
+    };
+    auto drain = [&]()
+    {
+        for (int i = 0; i < 5000 && (ran.load() != armed || periodic_ran.load() < periodic_armed); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            tw.go();
+        }
+    };
+
+    // the first lap of every wheel level touches the arena and the pool
+    for (uint32_t k = 0; k < 3000; k++)
+    {
+        round(k);
+    }
+    drain();
+    auto allocs_before = allocs.load();
+    auto faults_before = minor_faults();
+    for (uint32_t k = 0; k < 20000; k++)
+    {
+        round(k);
+    }
+    drain();
+    auto new_allocs = allocs.load() - allocs_before;
+    auto new_faults = minor_faults() - faults_before;
+
+    printf("armed %ld ran %ld keyed ran %ld allocs %ld faults %ld memory locked %d cascade peak %u\n", armed,
+           ran.load(), keyed_ran.load(), new_allocs, new_faults, tw.memory_locked(), tw.cascade_peak());
+    // a later cycle of a periodic timer is dropped when it finds the arena
+    // full, the first one always runs
+    if (ran.load() != armed || periodic_ran.load() < periodic_armed)
+    {
+        printf("FAIL: armed tasks did not all run\n");
+        return 1;
+    }
+    if (keyed_ran.load() == 0)
+    {
+        printf("FAIL: no debounce or throttle ran\n");
+        return 1;
+    }
+    if (tw.cascade_peak() > config.max_cascade)
+    {
+        printf("FAIL: a go() moved more than max_cascade nodes\n");
+        return 1;
+    }
+    if (new_allocs != 0)
+    {
+        printf("FAIL: allocated after warm-up\n");
+        return 1;
+    }
+    // without mlockall the kernel may reclaim and refault the arena
+    if (tw.memory_locked() && new_faults != 0)
+    {
+        printf("FAIL: page faults after warm-up\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+// four forked clients arm and cancel timers on one shared wheel; checks none
+// fires early or is lost, cancelled ones stay quiet, and the slots of clients
+// that exit or crash without detaching are reclaimed
+#include "sharedwheel.h"
+#include <algorithm>
+#include <poll.h>
+#include <random>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+static int run_client(const std::string &name, int id)
+{
+    SharedTimerClient client(name);
+    if (!client.valid())
+    {
+        printf("client %d: attach failed\n", id);
+        return 1;
+    }
+    std::mt19937 rng(id);
+    constexpr int COUNT = 3000;
+    std::vector<uint32_t> ids(COUNT), armed_at(COUNT), delay(COUNT);
+    std::vector<int64_t> fired(COUNT, -1);
+    int bad = 0;
+    int64_t lag = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        delay[i] = rng() % 600;
+        // the request ring or the node quota may be full until the wheel catches up
+        for (int tries = 0; tries < 10000; tries++)
+        {
+            armed_at[i] = client.now();
+            ids[i] = client.set_timer(RelativeTimeTick{delay[i]}, [&, i]() { fired[i] = client.now() - 1; });
+            if (ids[i] != 0)
+            {
+                break;
+            }
+            usleep(200);
+        }
+        if (ids[i] == 0)
+        {
+            printf("client %d: arming %d failed\n", id, i);
+            return 1;
+        }
+    }
+    int expect = 0;
+    for (int i = 0; i < COUNT; i++)
+    {
+        if (i % 5 != 0)
+        {
+            expect++;
+            continue;
+        }
+        int tries = 0;
+        while (!client.cancel(ids[i]) && tries++ < 10000)
+        {
+            usleep(100);
+        }
+        bad += tries >= 10000;
+    }
+    size_t got = 0;
+    while (got < static_cast<size_t>(expect))
+    {
+        pollfd pfd{client.native_handle(), POLLIN, 0};
+        if (poll(&pfd, 1, 3000) == 0)
+        {
+            printf("client %d: timed out with %zu of %d fired\n", id, got, expect);
+            return 1;
+        }
+        got += client.process_ready();
+    }
+    for (int i = 0; i < COUNT; i++)
+    {
+        if (i % 5 == 0)
+        {
+            bad += fired[i] != -1;
+            continue;
+        }
+        int64_t due = armed_at[i] + delay[i];
+        bad += fired[i] < due;
+        lag = std::max(lag, fired[i] - due);
+    }
+    // nodes must have been recycled to arm again
+    int again = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        client.set_timer(RelativeTimeTick{1}, [&]() { again++; });
+    }
+    for (int i = 0; i < 30 && again < 100; i++)
+    {
+        pollfd pfd{client.native_handle(), POLLIN, 0};
+        poll(&pfd, 1, 100);
+        client.process_ready();
+    }
+    printf("client %d: fired %zu of %d, early, lost or stray %d, max lag %lld ticks\n", id, got, expect, bad,
+           static_cast<long long>(lag));
+    return bad != 0 || again != 100;
+}
+
+int main()
+{
+    auto name = "/tw_shared_test_" + std::to_string(getpid());
+    shm_unlink(name.c_str());
+    SharedWheel wheel(name, SharedWheelConfig{1 << 14, 4, 1024});
+    if (!wheel.valid())
+    {
+        printf("FAIL: could not create the shared wheel\n");
+        return 1;
+    }
+    fflush(stdout);
+    int alive = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (fork() == 0)
+        {
+            int rc = run_client(name, i);
+            fflush(stdout);
+            _exit(rc);
+        }
+        alive++;
+    }
+    int failed = 0;
+    while (alive > 0)
+    {
+        wheel.go();
+        std::this_thread::sleep_for(std::chrono::microseconds(300));
+        int status;
+        while (waitpid(-1, &status, WNOHANG) > 0)
+        {
+            alive--;
+            failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+        }
+    }
+
+    // one client exits with a timer armed, another crashes right away
+    if (fork() == 0)
+    {
+        SharedTimerClient client(name);
+        client.set_timer(RelativeTimeTick{100000}, []() {});
+        _exit(0);
+    }
+    if (fork() == 0)
+    {
+        abort();
+    }
+    while (wait(nullptr) > 0)
+    {
+    }
+    // every slot is probed once per reap period
+    for (int i = 0; i < 2100; i++)
+    {
+        wheel.go();
+    }
+    int reusable = 0;
+    {
+        SharedTimerClient a(name), b(name), c(name), d(name);
+        reusable = a.valid() + b.valid() + c.valid() + d.valid();
+    }
+    printf("clients failed %d, slots reusable %d of 4\n", failed, reusable);
+    shm_unlink(name.c_str());
+    return failed != 0 || reusable != 4;
+}
@@ -0,0 +1,47 @@
+// 200 tasks of one strand due on the same tick must run one at a time and in
+// the order they were set, over several fresh wheels
+#include "scheduler.h"
+
+int main()
+{
+    constexpr int COUNT = 200;
+    int failed = 0;
+    for (int round = 0; round < 5; round++)
+    {
+        Scheduler tw;
+        std::atomic<int> running{0}, overlap{0}, total{0};
+        std::vector<int> order;
+        std::mutex mtx;
+        for (int i = 0; i < COUNT; i++)
+        {
+            tw.set_task(StrandID{9}, RelativeTimeTick{1}, [&, i]() {
+                if (++running > 1)
+                {
+                    overlap++;
+                }
+                {
+                    std::lock_guard<std::mutex> grd(mtx);
+                    order.push_back(i);
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(10));
+                running--;
+                total++;
+            });
+        }
+        for (int i = 0; i < 1000 && total < COUNT; i++)
+        {
+            tw.go();
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        int inversions = 0;
+        std::lock_guard<std::mutex> grd(mtx);
+        for (size_t i = 1; i < order.size(); i++)
+        {
+            inversions += order[i] < order[i - 1];
+        }
+        printf("round %d: ran %d of %d, inversions %d, overlapping %d\n", round, total.load(), COUNT, inversions,
+               overlap.load());
+        failed += total != COUNT || inversions != 0 || overlap != 0;
+    }
+    return failed != 0;
+}
@@ -0,0 +1,75 @@
+// records a mixed workload through the recorder hook, round-trips it through
+// save() and load(), and checks the replay fires the same timers on the same
+// ticks in the same order; owner 7 and debounce key 7 collide on purpose
+#include "timerreplay.h"
+#include <sstream>
+#include <tuple>
+
+// arm tick, op, key, ticks and the tick it fired on
+using firing = std::tuple<uint32_t, char, uint64_t, uint32_t, uint32_t>;
+
+int main()
+{
+    Scheduler source(VirtualClock{});
+    std::vector<firing> expected;
+    std::vector<TimerEvent> events;
+    {
+        TimerRecorder recorder(source);
+        // a task knows the operation that armed it, as replay's events do
+        auto task = [&](char op, uint64_t key, uint32_t ticks)
+        {
+            auto armed = source.now();
+            return [&, armed, op, key, ticks]()
+            { expected.emplace_back(armed, op, key, ticks, source.now() - 1); };
+        };
+        for (uint32_t t = 0; t < 3000; t++)
+        {
+            source.set_task(RelativeTimeTick{t % 17 + 1}, TaskObj{0, 0, 0xFFFFFFFF, 1, task('s', 0, t % 17 + 1)});
+            if (t % 5 == 0)
+            {
+                uint64_t owner = t % 10 == 0 ? 7 : 100 + t % 3;
+                source.set_task(OwnerID{owner}, RelativeTimeTick{t % 40 + 5},
+                                TaskObj{0, 0, 0xFFFFFFFF, 1, task('s', owner, t % 40 + 5)});
+            }
+            if (t % 3 == 0)
+            {
+                source.debounce(7, RelativeTimeTick{4}, task('d', 7, 4));
+            }
+            if (t % 2 == 0)
+            {
+                source.throttle(8, RelativeTimeTick{6}, task('t', 8, 6));
+            }
+            // the two cancels of key 7 must not touch each other's timers
+            if (t % 50 == 24)
+            {
+                source.cancel_keyed(7);
+            }
+            if (t % 50 == 49)
+            {
+                source.cancel_all(OwnerID{7});
+                source.cancel_all(OwnerID{101});
+            }
+            source.go();
+        }
+        while (source.step())
+        {
+        }
+        events = recorder.events();
+    }
+
+    std::stringstream file;
+    TimerReplay::save(file, events);
+    auto loaded = TimerReplay::load(file);
+    Scheduler target(VirtualClock{});
+    TimerReplay replay(target);
+    std::vector<firing> replayed;
+    replay.run(loaded, [&](const TimerEvent &ele, uint32_t tick)
+               { replayed.emplace_back(ele.tick, ele.op, ele.key, ele.ticks, tick); });
+    printf("recorded %zu events, fired %zu, replay fired %zu\n", events.size(), expected.size(), replayed.size());
+    if (loaded.size() != events.size() || replayed != expected)
+    {
+        printf("FAIL: replay differs from the recorded run\n");
+        return 1;
+    }
+    return 0;
+}
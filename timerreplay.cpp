@@ -0,0 +1,121 @@
+#include "timerreplay.h"
+#include <sstream>
+#include <string>
+
+std::vector<TimerEvent> TimerReplay::load(std::istream &is)
+{
+    std::vector<TimerEvent> events;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+        std::istringstream fields(line);
+        TimerEvent ele{};
+        if (!(fields >> ele.tick >> ele.op >> ele.key >> ele.ticks))
+        {
+            break;
+        }
+        events.push_back(ele);
+    }
+    return events;
+}
+
+void TimerReplay::save(std::ostream &os, const std::vector<TimerEvent> &events)
+{
+    for (auto &ele : events)
+    {
+        os << ele.tick << ' ' << ele.op << ' ' << ele.key << ' ' << ele.ticks << '\n';
+    }
+}
+
+size_t TimerReplay::run(const std::vector<TimerEvent> &_events, on_fire_t _on_fire)
+{
+    if (!tw.simulated())
+    {
+        return 0;
+    }
+    events = &_events;
+    on_fire = std::move(_on_fire);
+    fired = 0;
+    for (size_t i = 0; i < _events.size(); i++)
+    {
+        auto due = _events[i].tick;
+        if (static_cast<int32_t>(due - tw.now()) > 0)
+        {
+            tw.advance(due - tw.now());
+        }
+        apply(i);
+    }
+    while (tw.step())
+    {
+    }
+    events = nullptr;
+    return fired;
+}
+
+void TimerReplay::apply(size_t index)
+{
+    auto &ele = (*events)[index];
+    // this plus an index keeps the callable inside std::function's local buffer
+    auto fn = [this, index]()
+    { fire(index); };
+    switch (ele.op)
+    {
+    case 's':
+        if (ele.key != 0)
+        {
+            tw.set_task(OwnerID{ele.key}, RelativeTimeTick{ele.ticks}, TaskObj{0, 0, 0xFFFFFFFF, 1, fn});
+        }
+        else
+        {
+            tw.set_task(RelativeTimeTick{ele.ticks}, TaskObj{0, 0, 0xFFFFFFFF, 1, fn});
+        }
+        break;
+    case 'd':
+        tw.debounce(ele.key, RelativeTimeTick{ele.ticks}, fn);
+        break;
+    case 't':
+        tw.throttle(ele.key, RelativeTimeTick{ele.ticks}, fn);
+        break;
+    case 'c':
+        tw.cancel_keyed(ele.key);
+        break;
+    case 'o':
+        tw.cancel_all(OwnerID{ele.key});
+        break;
+    default:
+        break;
+    }
+}
+
+void TimerReplay::fire(size_t index)
+{
+    fired++;
+    if (on_fire)
+    {
+        // tasks run after go() has moved currtick past their tick
+        on_fire((*events)[index], tw.now() - 1);
+    }
+}
+
+TimerRecorder::TimerRecorder(Scheduler &_tw) : tw(_tw)
+{
+    tw.set_recorder([this](uint32_t tick, char op, uint64_t key, uint32_t ticks)
+                    {
+                        std::lock_guard<std::mutex> grd(mtx);
+                        recorded.push_back(TimerEvent{tick, op, key, ticks}); });
+}
+
+TimerRecorder::~TimerRecorder()
+{
+    tw.set_recorder({});
+}
+
+std::vector<TimerEvent> TimerRecorder::events() const
+{
+    std::lock_guard<std::mutex> grd(mtx);
+    return recorded;
+}
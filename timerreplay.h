@@ -0,0 +1,70 @@
+#ifndef USER_TIMERREPLAY_HEADER
+#define USER_TIMERREPLAY_HEADER
+
+#include "scheduler.h"
+#include <istream>
+#include <ostream>
+
+// one recorded timer operation, applied once virtual time reaches tick
+struct TimerEvent
+{
+    uint32_t tick;
+    // 's' one-shot after ticks, owned by key if non-zero, 'd' debounce,
+    // 't' throttle, 'c' cancel the debounce or throttle of key, 'o' cancel
+    // every timer owned by key
+    char op;
+    uint64_t key;
+    uint32_t ticks;
+};
+
+// replays a recorded timer workload on a virtual clock scheduler and reports
+// every expiry in the order the wheel fires it, identical from run to run
+class TimerReplay
+{
+public:
+    using on_fire_t = std::function<void(const TimerEvent &, uint32_t tick)>;
+
+    explicit TimerReplay(Scheduler &_tw) : tw(_tw) {}
+
+    // one "tick op key ticks" line per event, '#' starts a comment line;
+    // stops at the first malformed line
+    static std::vector<TimerEvent> load(std::istream &is);
+
+    static void save(std::ostream &os, const std::vector<TimerEvent> &events);
+
+    // applies events in tick order and then runs until the wheel is empty,
+    // returns the number of timers fired; nothing happens on a real clock
+    size_t run(const std::vector<TimerEvent> &events, on_fire_t on_fire = {});
+
+private:
+    void apply(size_t index);
+
+    void fire(size_t index);
+
+private:
+    Scheduler &tw;
+    const std::vector<TimerEvent> *events{};
+    on_fire_t on_fire;
+    size_t fired{};
+};
+
+// collects the operations of a live scheduler through its recorder hook,
+// ticks as the scheduler saw them, ready for save() or run()
+class TimerRecorder
+{
+public:
+    explicit TimerRecorder(Scheduler &_tw);
+    ~TimerRecorder();
+
+    TimerRecorder(const TimerRecorder &) = delete;
+    TimerRecorder &operator=(const TimerRecorder &) = delete;
+
+    // a copy of everything recorded so far
+    std::vector<TimerEvent> events() const;
+
+private:
+    Scheduler &tw;
+    mutable std::mutex mtx;
+    std::vector<TimerEvent> recorded;
+};
+#endif